@@ -16,9 +16,11 @@ Description :
 
 The application is composed of three sections :
 
-- System Initialization - Initializes I2C module and sets INT pin as INPUT
+- System Initialization - Initializes I2C module, sets INT pin as INPUT and starts the 1 ms tick timer
 - Application Initialization - Initializes driver init and configuration chip
-- Application Task - (code snippet) - Includes measurements, reads distance, and logs distance to USBUART for every 300 ms.
+- Application Task - (code snippet) - Includes measurements and sends every sample to USBUART as binary telemetry,
+                                      TELEMETRY_BATCH samples per frame (lightranger3_frameAdd). Decode on the host
+                                      with __lightranger3_decoder.c. Tick deltas are in ms, from a 1 ms timer interrupt.
                                       Distance measurement at distances ranging from 100 mm to 2000 mm
 
 */
@@ -26,8 +28,40 @@ The application is composed of three sections :
 #include "Click_LightRanger_3_types.h"
 #include "Click_LightRanger_3_config.h"
 
-uint16_t Distance;
-char DistanceTxt[20] = { 0 };
+// Samples per telemetry frame, 1 to 8
+#define TELEMETRY_BATCH     4
+
+T_lightranger3_sample Sample;
+T_lightranger3_frame Frame;
+uint8_t FrameLen;
+
+// SysTick registers, the same on every Cortex-M core
+#define SYST_CSR    (*(volatile uint32_t*)0xE000E010)
+#define SYST_RVR    (*(volatile uint32_t*)0xE000E014)
+#define SYST_CVR    (*(volatile uint32_t*)0xE000E018)
+
+volatile uint32_t TickMs;
+
+// SysTick every 1 ms at 72 MHz
+void timerInit()
+{
+    SYST_RVR = 72000 - 1;
+    SYST_CVR = 0;
+    // Core clock, interrupt and counter on
+    SYST_CSR = 0x07;
+    EnableInterrupts();
+}
+
+void timerIsr() iv IVT_INT_SysTick ics ICS_AUTO
+{
+    TickMs++;
+}
+
+uint32_t tickMs()
+{
+    // A single 32 bit load
+    return TickMs;
+}
 
 void systemInit()
 {
@@ -35,6 +69,8 @@ void systemInit()
     mikrobus_i2cInit( _MIKROBUS1, &_LIGHTRANGER3_I2C_CFG[0] );
     mikrobus_logInit( _LOG_USBUART_A, 9600 );
     
+    timerInit();
+
     mikrobus_logWrite( " --- System Init --- ", _LOG_LINE );
     Delay_ms( 100 );
 }
@@ -42,9 +78,13 @@ void systemInit()
 void applicationInit()
 {
     lightranger3_i2cDriverInit( (T_LIGHTRANGER3_P)&_MIKROBUS1_GPIO, (T_LIGHTRANGER3_P)&_MIKROBUS1_I2C, 0x4C );
+    // Sample timestamps and the frame tick deltas count in ms
+    lightranger3_setTickSource( tickMs );
+    lightranger3_setTickPeriod( 1000 );
     if(lightranger3_init() == 0)
     {
         mikrobus_logWrite( " --- Device init successfully --- ", _LOG_LINE );
+        lightranger3_frameInit( &Frame, TELEMETRY_BATCH );
     }
     else
     {
@@ -52,16 +92,26 @@ void applicationInit()
     }
 }
 
+void telemetryWrite(uint8_t *buf, uint8_t len)
+{
+    uint8_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        mikrobus_logWrite( &buf[ i ], _LOG_BYTE );
+    }
+}
+
 void applicationTask()
 {
-      lightranger3_takeSingleMeasurement();
-      
-      Distance = lightranger3_getDistance();
-      IntToStr(Distance,DistanceTxt);
-      mikrobus_logWrite( "Distance =", _LOG_TEXT );
-      mikrobus_logWrite( DistanceTxt, _LOG_TEXT );
-      mikrobus_logWrite( " mm", _LOG_LINE );
-      Delay_ms( 300 );
+    lightranger3_takeSingleMeasurement();
+    lightranger3_getSample( &Sample );
+
+    FrameLen = lightranger3_frameAdd( &Frame, &Sample );
+    if (FrameLen != 0)
+    {
+        telemetryWrite( Frame.buf, FrameLen );
+    }
 }
 
 void main()
@@ -0,0 +1,438 @@
+/*
+Benchmark for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_bench.c \
+        ../../../library/__lightranger3_driver.c -o lightranger3_bench
+
+    With HAL call counters, needed for syscalls_per_meas in the baseline :
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -D__HAL_I2C_STATS__ -I../../../library Click_LightRanger_3_LINUX_bench.c \
+        ../../../library/__lightranger3_driver.c -o lightranger3_bench
+
+---
+
+Description :
+
+Runs the unmodified driver against the RFD77402 simulator and prints one JSON
+object with the cost of every phase:
+
+- init        - lightranger3_init
+- transitions - standby, off and on mode changes
+- measurement - steady state lightranger3_takeSingleMeasurement loop
+- duty_cycle  - repeated wake cycles of init, one measurement and standby,
+                the pattern of a battery powered node
+- cold_start  - time to first distance from a power cycled sensor, init
+                and one measurement
+- warm_resume - time to first distance after lightranger3_suspend,
+                lightranger3_resume and one measurement
+- lost_resume - the same, but the sensor was power cycled while suspended
+                so resume falls back to the init sequence
+- interval_us - driver interval statistics of the measurement phase, from
+                the ready tick of every sample
+
+With --baseline the steady state loop is also run against the code paths
+each optimization replaced, and a baseline object lists both side by side:
+
+- burst_read  - RESULT and RESULT_CONFIG read as two 2 byte transactions,
+                the original takeSingleMeasurement, against the 4 byte burst
+- ready_mode  - ICSR polling against waiting on the INT pin
+- cpu_us      - time per measurement spent inside the driver and time left
+                to the caller, blocking takeSingleMeasurement against the
+                start/poll/result state machine polled every 50 us, for
+                both ready modes. Bus transfers count as driver time
+- syscalls_per_meas - kernel calls per polled measurement of the I2C_RDWR
+                back-end, one ioctl per transfer, against a write()/read()
+                back-end that needs one call per HAL write or read. Only
+                with __HAL_I2C_STATS__
+
+Times are virtual microseconds of the simulated bus, so results depend only
+on the options and are reproducible from run to run.
+
+Options :
+
+    --bus-hz N       SCL frequency (default 100000)
+    --meas-us N      sensor integration time (default 100)
+    --jitter-us N    integration time jitter (default 0)
+    --trans-us N     standby/off/on transition time (default 20)
+    --count N        measurements in the steady state phase (default 10000)
+    --cycles N       wake cycles in the duty cycle phase (default 1000)
+    --int            wait on INT pin instead of polling ICSR
+    --baseline       also measure the replaced code paths
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_sim.h"
+
+typedef struct
+{
+    uint32_t    transfers;
+    uint32_t    bytes;
+    uint64_t    us;
+
+}T_phase;
+
+uint32_t busHz    = 100000;
+uint32_t measUs   = 100;
+uint32_t jitterUs = 0;
+uint32_t transUs  = 20;
+uint32_t count    = 10000;
+uint32_t cycles   = 1000;
+uint8_t  useInt   = 0;
+uint8_t  baseline = 0;
+
+uint8_t  simDev;
+T_lightranger3_simStats mark;
+uint64_t markUs;
+
+void phaseBegin()
+{
+    lightranger3_simGetStats( simDev, &mark );
+    markUs = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+}
+
+void phaseEnd(T_phase *phase)
+{
+    T_lightranger3_simStats now;
+
+    lightranger3_simGetStats( simDev, &now );
+    phase->transfers = now.transfers - mark.transfers;
+    phase->bytes     = now.bytes - mark.bytes;
+    phase->us        = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - markUs;
+}
+
+void printPhase(const char *name, T_phase *phase, const char *sep)
+{
+    printf( "  \"%s\": {\"transactions\": %u, \"bytes\": %u, \"us\": %llu}%s\n",
+            name, phase->transfers, phase->bytes, (unsigned long long)phase->us, sep );
+}
+
+#define POLL_SLICE_US   50
+
+void Delay_10us();
+void Delay_us(uint32_t us);
+
+uint64_t driverUs;
+uint64_t callerUs;
+
+// Measurement as the driver did it before the burst read: 10 ICSR polls 10 us
+// apart, then RESULT and RESULT_CONFIG in two separate transactions
+uint8_t legacyMeasurement()
+{
+    uint16_t result;
+    uint8_t  x;
+
+    lightranger3_writeByte( _LIGHTRANGER3_REG_CMD, _LIGHTRANGER3_MEASUREMENT_MODE );
+    for (x = 0; x < 10; x++)
+    {
+        if ((lightranger3_readByte( _LIGHTRANGER3_REG_ICSR ) & (1 << 4)) != 0)
+        {
+            break;
+        }
+        Delay_10us();
+    }
+    if (x == 10)
+    {
+        return 1;
+    }
+    result = lightranger3_readData( _LIGHTRANGER3_REG_RESULT );
+    if (_LIGHTRANGER3_FIELD_GET( result, _LIGHTRANGER3_RESULT_VALID ) == 0
+        || _LIGHTRANGER3_FIELD_GET( result, _LIGHTRANGER3_RESULT_ERROR ) != 0)
+    {
+        return 1;
+    }
+    lightranger3_readData( _LIGHTRANGER3_REG_RESULT_CONFIG );
+
+    return 0;
+}
+
+// Blocking measurement, the caller gets no time back until it returns
+uint8_t blockingMeasurement()
+{
+    uint64_t t0;
+    uint8_t  res;
+
+    t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    res = lightranger3_takeSingleMeasurement();
+    driverUs += lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0;
+
+    return res;
+}
+
+// Non-blocking measurement, the caller works in POLL_SLICE_US slices between polls
+uint8_t stepMeasurement()
+{
+    uint64_t t0;
+    uint8_t  step;
+
+    t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    lightranger3_startMeasurement();
+    step = lightranger3_poll();
+    driverUs += lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0;
+    while (step == _LIGHTRANGER3_STEP_PENDING)
+    {
+        t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+        Delay_us( POLL_SLICE_US );
+        callerUs += lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0;
+
+        t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+        step = lightranger3_poll();
+        driverUs += lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0;
+    }
+    if (step != _LIGHTRANGER3_STEP_READY)
+    {
+        return 1;
+    }
+    return lightranger3_getResult();
+}
+
+void printCpu(const char *name, uint64_t inDriver, uint64_t toCaller, const char *sep)
+{
+    printf( "       \"%s\": {\"driver_us_per_meas\": %.1f, \"caller_us_per_meas\": %.1f, \"caller_share\": %.3f}%s\n",
+            name, (double)inDriver / count, (double)toCaller / count,
+            inDriver + toCaller ? (double)toCaller / (inDriver + toCaller) : 0.0, sep );
+}
+
+// Runs count measurements through one code path
+uint32_t measureLoop(T_phase *phase, uint8_t (*measure)())
+{
+    uint32_t i;
+    uint32_t errors = 0;
+
+    phaseBegin();
+    for (i = 0; i < count; i++)
+    {
+        errors += measure() != 0;
+    }
+    phaseEnd( phase );
+
+    return errors;
+}
+
+void printCompare(const char *name, const char *before, T_phase *b, const char *after, T_phase *a, const char *sep)
+{
+    printf( "    \"%s\": {\"%s\": {\"transactions_per_meas\": %.2f, \"bytes_per_meas\": %.2f, \"us_per_meas\": %.1f},\n",
+            name, before, (double)b->transfers / count, (double)b->bytes / count, (double)b->us / count );
+    printf( "      \"%s\": {\"transactions_per_meas\": %.2f, \"bytes_per_meas\": %.2f, \"us_per_meas\": %.1f}}%s\n",
+            after, (double)a->transfers / count, (double)a->bytes / count, (double)a->us / count, sep );
+}
+
+int cmpU32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--bus-hz" ) && i + 1 < argc)         busHz    = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--meas-us" ) && i + 1 < argc)   measUs   = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--jitter-us" ) && i + 1 < argc) jitterUs = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--trans-us" ) && i + 1 < argc)  transUs  = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--count" ) && i + 1 < argc)     count    = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--cycles" ) && i + 1 < argc)    cycles   = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--int" ))                       useInt   = 1;
+        else if (!strcmp( argv[ i ], "--baseline" ))                  baseline = 1;
+    }
+
+    simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, 0x4C );
+    lightranger3_simSetBusSpeed( _LIGHTRANGER3_I2C_BUS.devPath, busHz );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_STANDBY, transUs );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_OFF, transUs );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_ON, transUs );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_MEASUREMENT, measUs );
+    lightranger3_simSetJitter( simDev, jitterUs );
+}
+
+int main(int argc, char **argv)
+{
+    T_phase  init, standby, off, on, meas, duty, cold, warm, lost;
+    T_phase  burstBefore, burstAfter, readyPoll, readyInt, blocking, stepped;
+    uint64_t cpuUs[ 2 ][ 3 ];
+#ifdef __HAL_I2C_STATS__
+    T_phase  sysPhase;
+    T_lightranger3_busStats bus;
+#endif
+    uint8_t  mode;
+    T_lightranger3_intervalStats interval;
+    uint32_t *lat;
+    uint32_t i;
+    uint32_t errors = 0;
+    uint64_t t0;
+    uint32_t tStandby, tOff, tOn;
+
+    systemInit( argc, argv );
+
+    lightranger3_i2cDriverInit( lightranger3_simGpioObj( simDev ), (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS, 0x4C );
+    lightranger3_setTickSource( lightranger3_simTickUs );
+    if (useInt)
+    {
+        lightranger3_setReadyMode( _LIGHTRANGER3_READY_INT );
+    }
+
+    phaseBegin();
+    if (lightranger3_init() != 0)
+    {
+        printf( "{\"error\": \"init failed\"}\n" );
+        return 1;
+    }
+    phaseEnd( &init );
+
+    phaseBegin();
+    errors += lightranger3_setStandbyMode();
+    phaseEnd( &standby );
+    tStandby = lightranger3_getTransitionTime();
+    phaseBegin();
+    errors += lightranger3_setOffMode();
+    phaseEnd( &off );
+    tOff = lightranger3_getTransitionTime();
+    phaseBegin();
+    errors += lightranger3_setOnMode();
+    phaseEnd( &on );
+    tOn = lightranger3_getTransitionTime();
+
+    lat = malloc( count * sizeof( uint32_t ) );
+    lightranger3_resetIntervalStats();
+    phaseBegin();
+    for (i = 0; i < count; i++)
+    {
+        t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+        if (lightranger3_takeSingleMeasurement() != 0)
+        {
+            errors++;
+        }
+        lat[ i ] = (uint32_t)(lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0);
+    }
+    phaseEnd( &meas );
+    lightranger3_getIntervalStats( &interval );
+    qsort( lat, count, sizeof( uint32_t ), cmpU32 );
+
+    if (baseline)
+    {
+        lightranger3_setReadyMode( _LIGHTRANGER3_READY_POLL );
+        errors += measureLoop( &burstBefore, legacyMeasurement );
+        errors += measureLoop( &burstAfter, lightranger3_takeSingleMeasurement );
+        errors += measureLoop( &readyPoll, lightranger3_takeSingleMeasurement );
+        lightranger3_setReadyMode( _LIGHTRANGER3_READY_INT );
+        errors += measureLoop( &readyInt, lightranger3_takeSingleMeasurement );
+        for (mode = 0; mode < 2; mode++)
+        {
+            lightranger3_setReadyMode( mode ? _LIGHTRANGER3_READY_INT : _LIGHTRANGER3_READY_POLL );
+            driverUs = callerUs = 0;
+            errors += measureLoop( &blocking, blockingMeasurement );
+            cpuUs[ mode ][ 0 ] = driverUs;
+            driverUs = callerUs = 0;
+            errors += measureLoop( &stepped, stepMeasurement );
+            cpuUs[ mode ][ 1 ] = driverUs;
+            cpuUs[ mode ][ 2 ] = callerUs;
+        }
+#ifdef __HAL_I2C_STATS__
+        lightranger3_setReadyMode( _LIGHTRANGER3_READY_POLL );
+        lightranger3_resetBusStats();
+        errors += measureLoop( &sysPhase, lightranger3_takeSingleMeasurement );
+        lightranger3_getBusStats( 0x4C, &bus );
+#endif
+        lightranger3_setReadyMode( useInt ? _LIGHTRANGER3_READY_INT : _LIGHTRANGER3_READY_POLL );
+    }
+
+    phaseBegin();
+    for (i = 0; i < cycles; i++)
+    {
+        errors += lightranger3_init();
+        errors += lightranger3_takeSingleMeasurement();
+        errors += lightranger3_setStandbyMode();
+    }
+    phaseEnd( &duty );
+
+    lightranger3_simPowerCycle( simDev );
+    lightranger3_invalidateCache();
+    phaseBegin();
+    errors += lightranger3_init();
+    errors += lightranger3_takeSingleMeasurement();
+    phaseEnd( &cold );
+
+    errors += lightranger3_suspend();
+    phaseBegin();
+    errors += lightranger3_resume();
+    errors += lightranger3_takeSingleMeasurement();
+    phaseEnd( &warm );
+
+    errors += lightranger3_suspend();
+    lightranger3_simPowerCycle( simDev );
+    phaseBegin();
+    errors += lightranger3_resume();
+    errors += lightranger3_takeSingleMeasurement();
+    phaseEnd( &lost );
+
+    printf( "{\n" );
+    printf( "  \"bus_hz\": %u, \"meas_us\": %u, \"jitter_us\": %u, \"trans_us\": %u, \"ready\": \"%s\",\n",
+            busHz, measUs, jitterUs, transUs, useInt ? "int" : "poll" );
+    printPhase( "init", &init, "," );
+    printPhase( "standby", &standby, "," );
+    printPhase( "off", &off, "," );
+    printPhase( "on", &on, "," );
+    printf( "  \"transition_us\": {\"standby\": %u, \"off\": %u, \"on\": %u},\n", tStandby, tOff, tOn );
+    printPhase( "measurement", &meas, "," );
+    printPhase( "duty_cycle", &duty, "," );
+    printf( "  \"transactions_per_cycle\": %.2f, \"bytes_per_cycle\": %.2f,\n",
+            cycles ? (double)duty.transfers / cycles : 0.0, cycles ? (double)duty.bytes / cycles : 0.0 );
+    printPhase( "cold_start", &cold, "," );
+    printPhase( "warm_resume", &warm, "," );
+    printPhase( "lost_resume", &lost, "," );
+    printf( "  \"count\": %u, \"errors\": %u,\n", count, errors );
+    printf( "  \"meas_per_s\": %.1f,\n", meas.us ? count * 1e6 / meas.us : 0.0 );
+    printf( "  \"transactions_per_meas\": %.2f, \"bytes_per_meas\": %.2f,\n",
+            (double)meas.transfers / count, (double)meas.bytes / count );
+    printf( "  \"latency_us\": {\"min\": %u, \"p50\": %u, \"p99\": %u, \"max\": %u},\n",
+            lat[ 0 ], lat[ count / 2 ], lat[ (count * 99) / 100 ], lat[ count - 1 ] );
+    printf( "  \"interval_us\": {\"count\": %u, \"mean\": %u, \"min\": %u, \"max\": %u, \"jitter\": %u}%s\n",
+            interval.count, interval.meanUs, interval.minUs, interval.maxUs, interval.jitterUs, baseline ? "," : "" );
+    if (baseline)
+    {
+        printf( "  \"baseline\": {\n" );
+        printCompare( "burst_read", "separate", &burstBefore, "burst", &burstAfter, "," );
+        printCompare( "ready_mode", "poll", &readyPoll, "int", &readyInt, "," );
+        printf( "    \"cpu_us\": {\n" );
+        for (mode = 0; mode < 2; mode++)
+        {
+            printf( "     \"%s\": {\n", mode ? "int" : "poll" );
+            printCpu( "blocking", cpuUs[ mode ][ 0 ], 0, "," );
+            printCpu( "state_machine", cpuUs[ mode ][ 1 ], cpuUs[ mode ][ 2 ], "" );
+            printf( "     }%s\n", mode ? "" : "," );
+        }
+#ifdef __HAL_I2C_STATS__
+        printf( "    },\n" );
+        // One I2C_SLAVE ioctl when the address changes is left out of read_write
+        printf( "    \"syscalls_per_meas\": {\"read_write\": %.2f, \"i2c_rdwr\": %.2f}\n",
+                (double)(bus.writes + bus.reads) / count, (double)sysPhase.transfers / count );
+#else
+        printf( "    }\n" );
+#endif
+        printf( "  }\n" );
+    }
+    printf( "}\n" );
+
+    free( lat );
+    return 0;
+}
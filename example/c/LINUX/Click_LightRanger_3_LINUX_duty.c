@@ -0,0 +1,253 @@
+/*
+Duty cycle benchmark for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_duty.c \
+        ../../../library/__lightranger3_driver.c -o lightranger3_duty
+
+---
+
+Description :
+
+Samples a simulated sensor with lightranger3_dutySample at periods from
+2 ms to 1 s and, for comparison, with the sensor left on between samples.
+The simulator charges every power state with its own supply current and
+takes longer to wake from standby than from off. For every period it
+prints one JSON object with
+
+- sleep           - state the controller parks the sensor in
+- wake_us         - measured wake-up latency of that state
+- interval_us     - mean, min and max time between sample timestamps
+- overruns        - sample periods missed
+- driver_pct      - time per state as counted by the controller
+- sim_pct         - time per state as seen by the simulated sensor
+- avg_ua          - mean supply current, duty cycled and always on
+
+Options :
+
+    --samples N      samples per period (default 200)
+    --bus-hz N       SCL frequency (default 400000)
+    --meas-us N      integration time (default 2000)
+    --wake-us N      extra wake-up time from standby (default 3000)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_sim.h"
+
+void Delay_10us();
+
+static const char *stateName[ _LIGHTRANGER3_DUTY_STATES ] = { "standby", "off", "on", "measure" };
+
+uint32_t samples = 200;
+uint32_t busHz   = 400000;
+uint32_t measUs  = 2000;
+uint32_t wakeUs  = 3000;
+
+typedef struct
+{
+    double      meanUs;
+    uint32_t    minUs;
+    uint32_t    maxUs;
+    double      avgUa;
+    double      simPct[ _LIGHTRANGER3_SIM_PWR_COUNT ];
+
+}T_run;
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--samples" ) && i + 1 < argc)      samples = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--bus-hz" ) && i + 1 < argc)  busHz   = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--meas-us" ) && i + 1 < argc) measUs  = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--wake-us" ) && i + 1 < argc) wakeUs  = atoi( argv[ ++i ] );
+    }
+    if (samples < 2) samples = 2;
+}
+
+uint8_t sensorInit(T_lightranger3_simStats *start)
+{
+    uint8_t simDev;
+
+    lightranger3_simReset();
+    lightranger3_simSetBusSpeed( _LIGHTRANGER3_I2C_BUS.devPath, busHz );
+    simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_MEASUREMENT, measUs );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_STANDBY, 100 );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_OFF, 100 );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_ON, 300 );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_WAKE, wakeUs );
+
+    lightranger3_i2cDriverInit( lightranger3_simGpioObj( simDev ), (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS,
+                                _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_setTickSource( lightranger3_simTickUs );
+    if (lightranger3_init() != 0)
+    {
+        return 0xFF;
+    }
+    lightranger3_simGetStats( simDev, start );
+
+    return simDev;
+}
+
+void runFinish(T_run *run, uint8_t simDev, T_lightranger3_simStats *start, uint32_t first, uint32_t last,
+               uint32_t minUs, uint32_t maxUs)
+{
+    T_lightranger3_simStats end;
+    uint64_t total = 0;
+    uint8_t  i;
+
+    lightranger3_simGetStats( simDev, &end );
+    for (i = 0; i < _LIGHTRANGER3_SIM_PWR_COUNT; i++)
+    {
+        total += end.stateUs[ i ] - start->stateUs[ i ];
+    }
+    for (i = 0; i < _LIGHTRANGER3_SIM_PWR_COUNT; i++)
+    {
+        run->simPct[ i ] = 100.0 * (end.stateUs[ i ] - start->stateUs[ i ]) / total;
+    }
+    run->avgUa  = (double)(end.chargePc - start->chargePc) / total;
+    run->meanUs = (double)(last - first) / (samples - 1);
+    run->minUs  = minUs;
+    run->maxUs  = maxUs;
+}
+
+uint8_t runDuty(uint32_t periodUs, T_lightranger3_duty *duty, T_run *run)
+{
+    T_lightranger3_simStats start;
+    T_lightranger3_sample   smp;
+    uint32_t first = 0, prev = 0, minUs = 0xFFFFFFFF, maxUs = 0;
+    uint32_t i;
+    uint8_t  simDev;
+
+    simDev = sensorInit( &start );
+    if (simDev == 0xFF || lightranger3_dutyInit( duty, 0, periodUs ) != 0)
+    {
+        return 1;
+    }
+    lightranger3_simGetStats( simDev, &start );
+    for (i = 0; i < samples; i++)
+    {
+        lightranger3_dutySample( duty, &smp );
+        if (i == 0)
+        {
+            first = smp.timestamp;
+        }
+        else
+        {
+            if (smp.timestamp - prev < minUs) minUs = smp.timestamp - prev;
+            if (smp.timestamp - prev > maxUs) maxUs = smp.timestamp - prev;
+        }
+        prev = smp.timestamp;
+    }
+    runFinish( run, simDev, &start, first, prev, minUs, maxUs );
+
+    return 0;
+}
+
+uint8_t runAlwaysOn(uint32_t periodUs, T_run *run)
+{
+    T_lightranger3_simStats start;
+    T_lightranger3_sample   smp;
+    uint32_t first = 0, prev = 0, next, minUs = 0xFFFFFFFF, maxUs = 0;
+    uint32_t i;
+    uint8_t  simDev;
+
+    simDev = sensorInit( &start );
+    if (simDev == 0xFF)
+    {
+        return 1;
+    }
+    next = lightranger3_simTickUs();
+    for (i = 0; i < samples; i++)
+    {
+        while ((int32_t)(next - lightranger3_simTickUs()) > 0)
+        {
+            Delay_10us();
+        }
+        lightranger3_takeSingleMeasurement();
+        lightranger3_getSample( &smp );
+        next += periodUs;
+        if (i == 0)
+        {
+            first = smp.timestamp;
+        }
+        else
+        {
+            if (smp.timestamp - prev < minUs) minUs = smp.timestamp - prev;
+            if (smp.timestamp - prev > maxUs) maxUs = smp.timestamp - prev;
+        }
+        prev = smp.timestamp;
+    }
+    runFinish( run, simDev, &start, first, prev, minUs, maxUs );
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t periodsMs[] = { 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+    T_lightranger3_duty duty;
+    T_run    dc, on;
+    uint32_t total;
+    uint32_t p;
+    uint8_t  i;
+
+    systemInit( argc, argv );
+
+    printf( "[\n" );
+    for (p = 0; p < sizeof( periodsMs ) / sizeof( periodsMs[ 0 ] ); p++)
+    {
+        if (runDuty( periodsMs[ p ] * 1000, &duty, &dc ) != 0 || runAlwaysOn( periodsMs[ p ] * 1000, &on ) != 0)
+        {
+            printf( "{\"error\": \"sensor init failed\"}\n]\n" );
+            return 1;
+        }
+        total = 0;
+        for (i = 0; i < _LIGHTRANGER3_DUTY_STATES; i++)
+        {
+            total += duty.stateUs[ i ];
+        }
+
+        printf( "  {\"period_ms\": %u, \"sleep\": \"%s\", \"wake_us\": %u, \"measure_us\": %u, "
+                "\"interval_us\": {\"mean\": %.1f, \"min\": %u, \"max\": %u}, \"overruns\": %u,\n",
+                periodsMs[ p ], stateName[ duty.sleep ],
+                duty.sleep < _LIGHTRANGER3_DUTY_ON ? duty.wakeUs[ duty.sleep ] : 0, duty.measureUs,
+                dc.meanUs, dc.minUs, dc.maxUs, duty.overruns );
+        printf( "   \"driver_pct\": {" );
+        for (i = 0; i < _LIGHTRANGER3_DUTY_STATES; i++)
+        {
+            printf( "\"%s\": %.2f%s", stateName[ i ], 100.0 * duty.stateUs[ i ] / total,
+                    i + 1 < _LIGHTRANGER3_DUTY_STATES ? ", " : "},\n" );
+        }
+        printf( "   \"sim_pct\": {" );
+        for (i = 0; i < _LIGHTRANGER3_SIM_PWR_COUNT; i++)
+        {
+            printf( "\"%s\": %.2f%s", stateName[ i ], dc.simPct[ i ],
+                    i + 1 < _LIGHTRANGER3_SIM_PWR_COUNT ? ", " : "},\n" );
+        }
+        printf( "   \"avg_ua\": {\"duty\": %.1f, \"always_on\": %.1f}, \"saving_pct\": %.1f}%s\n",
+                dc.avgUa, on.avgUa, 100.0 * (1.0 - dc.avgUa / on.avgUa),
+                p + 1 < sizeof( periodsMs ) / sizeof( periodsMs[ 0 ] ) ? "," : "" );
+    }
+    printf( "]\n" );
+
+    return 0;
+}
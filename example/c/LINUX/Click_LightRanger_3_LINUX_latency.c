@@ -0,0 +1,200 @@
+/*
+Latency histogram example for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_latency.c \
+        ../../../library/__lightranger3_decoder.c ../../../library/__lightranger3_driver.c \
+        -o lightranger3_latency
+
+---
+
+Description :
+
+Measures with several simulated sensors on one bus, each with its own
+latency histograms. Sensor 0 integrates with a large jitter and every
+sensor reports a sensor error code now and then. The histograms are
+written out as the text lines a target would send over the log UART, parsed
+back per sensor and merged. For every sensor and for the merged set it
+prints one JSON object with p50, p99 and maximum of each phase and the
+fail counts (ready timeouts, results with an error code), then
+
+- hist_bytes      - RAM of one T_lightranger3_hist on this host
+- line_bytes      - longest dump line
+
+Latencies are virtual microseconds of the simulated bus. Percentiles are
+bucket upper bounds, capped at the largest latency seen, and at most 12.5 %
+above the true value with the 8 sub-buckets per power of two that
+simulator builds default to.
+
+Options :
+
+    --sensors N      sensors on the bus (default 4, at most 16)
+    --count N        measurements per sensor (default 5000)
+    --bus-hz N       SCL frequency (default 400000)
+    --meas-us N      integration time (default 2000)
+    --jitter-us N    integration jitter of sensors 1 and up (default 200)
+    --stall-us N     integration jitter of sensor 0 (default 30000)
+    --error-every N  one result in N carries an error code (default 50)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_decoder.h"
+#include "__lightranger3_sim.h"
+
+#define MAX_SENSORS     16
+
+uint32_t sensors    = 4;
+uint32_t count      = 5000;
+uint32_t busHz      = 400000;
+uint32_t measUs     = 2000;
+uint32_t jitterUs   = 200;
+uint32_t stallUs    = 30000;
+uint32_t errorEvery = 50;
+
+T_lightranger3_dev      sensor[ MAX_SENSORS ];
+T_lightranger3_hist     hist[ MAX_SENSORS ];
+T_lightranger3_histSum  perSensor[ MAX_SENSORS ];
+T_lightranger3_histSum  merged;
+T_lightranger3_simSample *script;
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--sensors" ) && i + 1 < argc)            sensors    = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--count" ) && i + 1 < argc)         count      = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--bus-hz" ) && i + 1 < argc)        busHz      = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--meas-us" ) && i + 1 < argc)       measUs     = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--jitter-us" ) && i + 1 < argc)     jitterUs   = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--stall-us" ) && i + 1 < argc)      stallUs    = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--error-every" ) && i + 1 < argc)   errorEvery = atoi( argv[ ++i ] );
+    }
+    if (sensors > MAX_SENSORS) sensors    = MAX_SENSORS;
+    if (sensors == 0)          sensors    = 1;
+    if (errorEvery == 0)       errorEvery = 1;
+}
+
+uint8_t sensorsInit()
+{
+    uint32_t i;
+    uint8_t  simDev;
+
+    script = calloc( errorEvery, sizeof( T_lightranger3_simSample ) );
+    for (i = 0; i < errorEvery; i++)
+    {
+        script[ i ].distance        = 500 + i;
+        script[ i ].confidenceValue = 1000;
+    }
+    script[ errorEvery - 1 ].errorCode = 2;
+
+    lightranger3_simSetBusSpeed( _LIGHTRANGER3_I2C_BUS.devPath, busHz );
+    lightranger3_setTickSource( lightranger3_simTickUs );
+    for (i = 0; i < sensors; i++)
+    {
+        simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, 0x40 + i );
+        lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_MEASUREMENT, measUs );
+        lightranger3_simSetJitter( simDev, i == 0 ? stallUs : jitterUs );
+        lightranger3_simSetProfile( simDev, script, errorEvery );
+        lightranger3_devI2cInit( &sensor[ i ], lightranger3_simGpioObj( simDev ),
+                                 (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS, 0x40 + i );
+        if (lightranger3_devInit( &sensor[ i ] ) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void run()
+{
+    uint32_t i, k;
+
+    for (k = 0; k < sensors; k++)
+    {
+        lightranger3_histInit( &hist[ k ] );
+        lightranger3_devAttachHist( &sensor[ k ], &hist[ k ] );
+    }
+    for (i = 0; i < count; i++)
+    {
+        for (k = 0; k < sensors; k++)
+        {
+            lightranger3_devTakeSingleMeasurement( &sensor[ k ] );
+        }
+    }
+}
+
+void printSum(const char *name, int tag, T_lightranger3_histSum *sum, const char *sep)
+{
+    static const char *phases[] = { "command", "ready", "readout" };
+    uint8_t p;
+
+    printf( "  {\"%s\": %d", name, tag );
+    for (p = 0; p < _LIGHTRANGER3_HIST_PHASES; p++)
+    {
+        printf( ", \"%s\": {\"p50\": %u, \"p99\": %u, \"max\": %u, \"fail\": %llu}", phases[ p ],
+                lightranger3_histPercentile( sum, p, 500 ), lightranger3_histPercentile( sum, p, 990 ),
+                lightranger3_histPercentile( sum, p, 1000 ), (unsigned long long)sum->fail[ p ] );
+    }
+    printf( "}%s\n", sep );
+}
+
+int main(int argc, char **argv)
+{
+    char     line[ _LIGHTRANGER3_HIST_LINE_MAX ];
+    uint32_t k;
+    uint16_t len, longest;
+    uint8_t  p;
+    int      tag;
+
+    systemInit( argc, argv );
+    if (sensorsInit() != 0)
+    {
+        printf( "{\"error\": \"sensor init failed\"}\n" );
+        return 1;
+    }
+
+    run();
+
+    // What the targets would send, one line per sensor and phase
+    lightranger3_histSumInit( &merged );
+    longest = 0;
+    for (k = 0; k < sensors; k++)
+    {
+        lightranger3_histSumInit( &perSensor[ k ] );
+        for (p = 0; p < _LIGHTRANGER3_HIST_PHASES; p++)
+        {
+            len = lightranger3_histFormat( &hist[ k ], p, 0x40 + k, line );
+            longest = len > longest ? len : longest;
+            tag = lightranger3_histParse( &merged, line );
+            lightranger3_histParse( &perSensor[ tag - 0x40 ], line );
+        }
+    }
+
+    printf( "[\n" );
+    for (k = 0; k < sensors; k++)
+    {
+        printSum( "sensor", 0x40 + k, &perSensor[ k ], "," );
+    }
+    printSum( "merged", sensors, &merged, "," );
+    printf( "  {\"hist_bytes\": %u, \"line_bytes\": %u}\n", (unsigned)sizeof( T_lightranger3_hist ), longest );
+    printf( "]\n" );
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+/*
+Multi-instance test for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_multi.c \
+        ../../../library/__lightranger3_driver.c -o lightranger3_multi
+
+    With HAL call counters, also checks the traffic seen per slave address :
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -D__HAL_I2C_STATS__ -D__HAL_I2C_STATS_SLOTS__=16 -I../../../library \
+        Click_LightRanger_3_LINUX_multi.c ../../../library/__lightranger3_driver.c -o lightranger3_multi
+
+---
+
+Description :
+
+Puts N simulated sensors on one virtual bus at 0x40, 0x41, ... and drives
+each through its own T_lightranger3_dev handle. Every sensor has its own
+scripted distance sequence, odd handles use the INT pin and the
+experimental fast profile, even handles poll with the balanced profile,
+and measurements are interleaved round robin so every handle's cached
+state sits next to the others' between calls.
+
+A sample read through handle i must come from sensor i in sequence, and
+every sensor must have taken exactly the measurements of its own handle.
+Prints JSON with sizeof(T_lightranger3_dev) and the mismatches per handle,
+exits with 1 on any crosstalk.
+
+Options :
+
+    --sensors N      number of sensors (default 8, at most 11)
+    --rounds N       measurements per sensor (default 100)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_sim.h"
+
+// 0x40 + 11 stays below the power up address 0x4C
+#define MAX_SENSORS     11
+#define PROFILE_LEN     4
+#define FIRST_ADDRESS   0x40
+
+uint32_t sensors  = 8;
+uint32_t rounds   = 100;
+
+uint8_t                  simDev[ MAX_SENSORS ];
+T_lightranger3_dev       sensor[ MAX_SENSORS ];
+T_lightranger3_simSample script[ MAX_SENSORS ][ PROFILE_LEN ];
+
+void systemInit(int argc, char **argv)
+{
+    uint32_t n, k;
+    int      i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--sensors" ) && i + 1 < argc)       sensors = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--rounds" ) && i + 1 < argc)   rounds  = atoi( argv[ ++i ] );
+    }
+    if (sensors > MAX_SENSORS)
+    {
+        sensors = MAX_SENSORS;
+    }
+
+    for (n = 0; n < sensors; n++)
+    {
+        // Distance encodes the sensor, confidence the position in its sequence
+        for (k = 0; k < PROFILE_LEN; k++)
+        {
+            script[ n ][ k ].distance        = 100 * (n + 1) + k;
+            script[ n ][ k ].confidenceValue = 10 * k + n;
+            script[ n ][ k ].errorCode       = 0;
+        }
+        simDev[ n ] = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, FIRST_ADDRESS + n );
+        lightranger3_simSetProfile( simDev[ n ], script[ n ], PROFILE_LEN );
+        lightranger3_devI2cInit( &sensor[ n ], lightranger3_simGpioObj( simDev[ n ] ),
+                                 (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS, FIRST_ADDRESS + n );
+        if (n & 1)
+        {
+            lightranger3_devSetReadyMode( &sensor[ n ], _LIGHTRANGER3_READY_INT );
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    T_lightranger3_simStats stats;
+    T_lightranger3_sample   sample;
+    uint32_t mismatch[ MAX_SENSORS ];
+    uint32_t total = 0;
+#ifdef __HAL_I2C_STATS__
+    T_lightranger3_busStats bus, all;
+    uint32_t calls = 0;
+#endif
+    uint32_t r;
+    uint8_t  i, k;
+
+    systemInit( argc, argv );
+    lightranger3_setTickSource( lightranger3_simTickUs );
+
+    for (i = 0; i < sensors; i++)
+    {
+        mismatch[ i ] = 0;
+        if (lightranger3_devInit( &sensor[ i ] ) != 0
+            || ((i & 1) && lightranger3_devSetProfile( &sensor[ i ], &_LIGHTRANGER3_PROFILE_EXP_FAST_SHORT ) != 0))
+        {
+            mismatch[ i ]++;
+        }
+    }
+
+#ifdef __HAL_I2C_STATS__
+    lightranger3_resetBusStats();
+#endif
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < sensors; i++)
+        {
+            k = r % PROFILE_LEN;
+            if (lightranger3_devTakeSingleMeasurement( &sensor[ i ] ) != 0)
+            {
+                mismatch[ i ]++;
+                continue;
+            }
+            lightranger3_devGetSample( &sensor[ i ], &sample );
+            if (sample.distance != script[ i ][ k ].distance
+                || sample.confidenceValue != script[ i ][ k ].confidenceValue)
+            {
+                mismatch[ i ]++;
+            }
+        }
+    }
+
+    printf( "{\n" );
+    printf( "  \"sizeof_dev\": %u, \"sensors\": %u, \"rounds\": %u,\n",
+            (unsigned)sizeof( T_lightranger3_dev ), sensors, rounds );
+    printf( "  \"handles\": [" );
+    for (i = 0; i < sensors; i++)
+    {
+        lightranger3_simGetStats( simDev[ i ], &stats );
+        if (stats.measurements != rounds)
+        {
+            mismatch[ i ]++;
+        }
+#ifdef __HAL_I2C_STATS__
+        // Every handle reads at least its result once per round from its own address
+        if (lightranger3_devGetBusStats( &sensor[ i ], &bus ) != 0 || bus.reads < rounds)
+        {
+            mismatch[ i ]++;
+        }
+        calls += bus.writes + bus.reads;
+#endif
+        total += mismatch[ i ];
+        printf( "%s\n    {\"address\": \"0x%02X\", \"ready\": \"%s\", \"measurements\": %u, \"mismatches\": %u",
+                i ? "," : "", sensor[ i ].slaveAddress, (i & 1) ? "int" : "poll", stats.measurements, mismatch[ i ] );
+#ifdef __HAL_I2C_STATS__
+        printf( ", \"hal_reads\": %u, \"hal_writes\": %u", bus.reads, bus.writes );
+#endif
+        printf( "}" );
+    }
+    printf( "\n  ],\n" );
+#ifdef __HAL_I2C_STATS__
+    // Calls to any address no handle owns
+    lightranger3_getBusStats( 0, &all );
+    total += all.writes + all.reads - calls;
+    printf( "  \"stray_hal_calls\": %u,\n", all.writes + all.reads - calls );
+#endif
+    printf( "  \"crosstalk\": %s\n}\n", total ? "true" : "false" );
+
+    return total != 0;
+}
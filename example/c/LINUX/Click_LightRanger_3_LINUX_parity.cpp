@@ -0,0 +1,298 @@
+/*
+C / C++ driver parity test for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc, g++
+
+    gcc -O2 -c -D__LIGHTRANGER3_SIM__ -I../../../library ../../../library/__lightranger3_driver.c \
+        -o lightranger3_driver.o
+    g++ -O2 -I../../../library Click_LightRanger_3_LINUX_parity.cpp lightranger3_driver.o -o lightranger3_parity
+
+---
+
+Description :
+
+Runs the same session twice on a freshly reset simulator, once through the
+C driver and once through lightranger3::Driver, and records every message
+on the bus with the virtual time it ended at. The session moves the sensor
+off its power up address, initializes it, measures, switches profile,
+initializes again without a reset, soft resets, initializes and measures.
+
+The C++ bus policy hands its transfers to the simulator the way the Linux
+HAL does, a write ending in a repeated START goes out with the read that
+follows. Prints JSON with the message count of each run and the first
+message that differs, exits with 1 unless both logs and both sets of
+results are the same.
+
+Options :
+
+    --meas N         measurements per phase (default 20)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_sim.h"
+#include "__lightranger3_driver.hpp"
+
+extern "C" void Delay_10us();
+
+#define SENSOR_ADDRESS  0x41
+#define MAX_LOG         8192
+#define MAX_MSG_BYTES   17
+#define PROFILE_LEN     5
+
+struct T_logEntry
+{
+    uint64_t    us;
+    uint8_t     address;
+    uint8_t     read;
+    uint8_t     nack;
+    uint8_t     len;
+    uint8_t     buf[ MAX_MSG_BYTES ];
+};
+
+struct T_log
+{
+    T_logEntry  entry[ MAX_LOG ];
+    uint32_t    count;
+    uint32_t    dropped;
+};
+
+struct T_run
+{
+    uint32_t    distanceSum;
+    uint32_t    confidenceSum;
+    uint32_t    errors;
+};
+
+static const T_lightranger3_simSample script[ PROFILE_LEN ] =
+{
+    { 120, 900, 0 }, { 480, 1200, 0 }, { 1500, 300, 0 }, { 0, 0, 2 }, { 860, 1750, 0 }
+};
+
+uint32_t meas = 20;
+
+static T_log  logs[ 2 ];
+static T_log  *curLog;
+
+static void logMessage(uint8_t address, uint8_t read, const uint8_t *buf, uint16_t len, uint8_t nack)
+{
+    T_logEntry *e;
+
+    if (curLog->count == MAX_LOG)
+    {
+        curLog->dropped++;
+        return;
+    }
+    e = &curLog->entry[ curLog->count++ ];
+    memset( e, 0, sizeof( T_logEntry ) );
+    e->us      = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    e->address = address;
+    e->read    = read;
+    e->nack    = nack;
+    e->len     = (uint8_t)len;
+    // A NACKed read leaves the buffer as the caller had it
+    if (!(read && nack))
+    {
+        memcpy( e->buf, buf, len < MAX_MSG_BYTES ? len : MAX_MSG_BYTES );
+    }
+}
+
+static void simSetup(T_log *log)
+{
+    uint8_t simDev;
+
+    lightranger3_simReset();
+    simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_simSetProfile( simDev, script, PROFILE_LEN );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_MEASUREMENT, 2000 );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_RESET, 5000 );
+
+    curLog = log;
+    curLog->count   = 0;
+    curLog->dropped = 0;
+    lightranger3_simSetTrace( _LIGHTRANGER3_I2C_BUS.devPath, logMessage );
+}
+
+/* ------------------------------------------------------- C++ BUS POLICY */
+
+struct SimBus
+{
+    static uint8_t pending[ 1 + 2 * lightranger3::MAX_BLOCK_REGS ];
+    static uint8_t pendingLen;
+
+    static uint8_t start()
+    {
+        pendingLen = 0;
+        return 0;
+    }
+
+    static uint8_t write(uint8_t slave, uint8_t *buf, uint8_t n, uint8_t end)
+    {
+        // Held back for the read, as the Linux HAL does
+        if (end == lightranger3::END_RESTART)
+        {
+            memcpy( pending, buf, n );
+            pendingLen = n;
+            return 0;
+        }
+        return lightranger3_simI2cTransfer( _LIGHTRANGER3_I2C_BUS.devPath, slave, buf, n, 0, 0 );
+    }
+
+    static uint8_t read(uint8_t slave, uint8_t *buf, uint8_t n, uint8_t /* end */)
+    {
+        uint8_t len = pendingLen;
+
+        pendingLen = 0;
+        return lightranger3_simI2cTransfer( _LIGHTRANGER3_I2C_BUS.devPath, slave, pending, len, buf, n );
+    }
+
+    static void delay10us()
+    {
+        Delay_10us();
+    }
+};
+
+uint8_t SimBus::pending[ 1 + 2 * lightranger3::MAX_BLOCK_REGS ];
+uint8_t SimBus::pendingLen = 0;
+
+/* ------------------------------------------------------------------ RUNS */
+
+static void runC(T_run *run)
+{
+    T_lightranger3_dev sensor;
+    uint32_t i;
+
+    memset( run, 0, sizeof( T_run ) );
+    simSetup( &logs[ 0 ] );
+
+    lightranger3_devI2cInit( &sensor, lightranger3_simGpioObj( 0 ), (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS,
+                             _LIGHTRANGER3_DEFAULT_ADDRESS );
+    run->errors += lightranger3_devSetAddress( &sensor, SENSOR_ADDRESS );
+    run->errors += lightranger3_devInit( &sensor );
+    for (i = 0; i < 4 * meas; i++)
+    {
+        // Phases: balanced, fast, fast after re-init, balanced after reset
+        if (i == meas)
+        {
+            run->errors += lightranger3_devSetProfile( &sensor, &_LIGHTRANGER3_PROFILE_EXP_FAST_SHORT );
+        }
+        else if (i == 2 * meas)
+        {
+            run->errors += lightranger3_devInit( &sensor );
+        }
+        else if (i == 3 * meas)
+        {
+            run->errors += lightranger3_devSetProfile( &sensor, &_LIGHTRANGER3_PROFILE_BALANCED );
+            run->errors += lightranger3_devSoftReset( &sensor );
+            run->errors += lightranger3_devInit( &sensor );
+        }
+        if (lightranger3_devTakeSingleMeasurement( &sensor ) == 0)
+        {
+            run->distanceSum   += lightranger3_devGetDistance( &sensor );
+            run->confidenceSum += lightranger3_devGetConfidenceValue( &sensor );
+        }
+    }
+    lightranger3_simSetTrace( _LIGHTRANGER3_I2C_BUS.devPath, 0 );
+}
+
+static void runCpp(T_run *run)
+{
+    lightranger3::Driver< SimBus, lightranger3::NoPin, SENSOR_ADDRESS > sensor;
+    uint32_t i;
+
+    memset( run, 0, sizeof( T_run ) );
+    simSetup( &logs[ 1 ] );
+
+    run->errors += sensor.setAddress();
+    run->errors += sensor.init();
+    for (i = 0; i < 4 * meas; i++)
+    {
+        if (i == meas)
+        {
+            run->errors += sensor.setProfile( &lightranger3::PROFILE_EXP_FAST_SHORT );
+        }
+        else if (i == 2 * meas)
+        {
+            run->errors += sensor.init();
+        }
+        else if (i == 3 * meas)
+        {
+            run->errors += sensor.setProfile( &lightranger3::PROFILE_BALANCED );
+            run->errors += sensor.softReset();
+            run->errors += sensor.init();
+        }
+        if (sensor.takeSingleMeasurement() == 0)
+        {
+            run->distanceSum   += sensor.getDistance();
+            run->confidenceSum += sensor.getConfidenceValue();
+        }
+    }
+    lightranger3_simSetTrace( _LIGHTRANGER3_I2C_BUS.devPath, 0 );
+}
+
+static int32_t firstMismatch()
+{
+    uint32_t i;
+
+    for (i = 0; i < logs[ 0 ].count && i < logs[ 1 ].count; i++)
+    {
+        if (memcmp( &logs[ 0 ].entry[ i ], &logs[ 1 ].entry[ i ], sizeof( T_logEntry ) ) != 0)
+        {
+            return (int32_t)i;
+        }
+    }
+    if (logs[ 0 ].count != logs[ 1 ].count)
+    {
+        return (int32_t)i;
+    }
+    return -1;
+}
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--meas" ) && i + 1 < argc)    meas = atoi( argv[ ++i ] );
+    }
+}
+
+int main(int argc, char **argv)
+{
+    T_run   c, cpp;
+    int32_t mismatch;
+    uint8_t same;
+
+    systemInit( argc, argv );
+
+    runC( &c );
+    runCpp( &cpp );
+    mismatch = firstMismatch();
+    same = (mismatch < 0 && logs[ 0 ].dropped == 0 && logs[ 1 ].dropped == 0 && c.errors == 0 && cpp.errors == 0
+            && c.distanceSum == cpp.distanceSum && c.confidenceSum == cpp.confidenceSum);
+
+    printf( "{\n" );
+    printf( "  \"c\": {\"messages\": %u, \"end_us\": %llu, \"errors\": %u, \"distance_sum\": %u},\n",
+            logs[ 0 ].count, (unsigned long long)(logs[ 0 ].count ? logs[ 0 ].entry[ logs[ 0 ].count - 1 ].us : 0),
+            c.errors, c.distanceSum );
+    printf( "  \"cpp\": {\"messages\": %u, \"end_us\": %llu, \"errors\": %u, \"distance_sum\": %u},\n",
+            logs[ 1 ].count, (unsigned long long)(logs[ 1 ].count ? logs[ 1 ].entry[ logs[ 1 ].count - 1 ].us : 0),
+            cpp.errors, cpp.distanceSum );
+    printf( "  \"first_mismatch\": %d, \"identical\": %s\n}\n", mismatch, same ? "true" : "false" );
+
+    return !same;
+}
@@ -0,0 +1,165 @@
+/*
+Measurement profile benchmark for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_profile.c \
+        ../../../library/__lightranger3_driver.c -o lightranger3_profile
+
+---
+
+Description :
+
+Switches a simulated sensor from the balanced profile to each of the
+built-in profiles and then measures with it. Balanced is the supported
+profile, the two EXP profiles are experimental. For every profile it prints
+one JSON object with
+
+- switch          - bus cost of lightranger3_setProfile from balanced
+- reinit          - bus cost of loading the same profile with a full
+                    lightranger3_init, for comparison
+- sim_meas_per_s  - measurement rate with the profile on the simulator
+- errors          - failed calls, must be 0
+
+The built-in profiles share their HW_FW_CONFIG words, so a switch only
+writes CMD_CONFIG_A and CMD_CONFIG_B.
+
+The rates are those of the simulator's latency model, not of the part: it
+scales the integration time with the CMD_CONFIG fields of the profile, see
+lightranger3_simSetLatency, and the result only shows how the profiles
+rank against each other. Times are virtual microseconds of the simulated
+bus and reproducible from run to run.
+
+Options :
+
+    --bus-hz N       SCL frequency (default 400000)
+    --meas-us N      simulated integration time of the balanced profile
+                     (default 2000)
+    --count N        measurements per profile (default 2000)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_sim.h"
+
+typedef struct
+{
+    uint32_t    transfers;
+    uint32_t    bytes;
+    uint64_t    us;
+
+}T_phase;
+
+uint32_t busHz  = 400000;
+uint32_t measUs = 2000;
+uint32_t count  = 2000;
+
+uint8_t  simDev;
+T_lightranger3_simStats mark;
+uint64_t markUs;
+
+void phaseBegin()
+{
+    lightranger3_simGetStats( simDev, &mark );
+    markUs = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+}
+
+void phaseEnd(T_phase *phase)
+{
+    T_lightranger3_simStats now;
+
+    lightranger3_simGetStats( simDev, &now );
+    phase->transfers = now.transfers - mark.transfers;
+    phase->bytes     = now.bytes - mark.bytes;
+    phase->us        = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - markUs;
+}
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--bus-hz" ) && i + 1 < argc)         busHz  = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--meas-us" ) && i + 1 < argc)   measUs = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--count" ) && i + 1 < argc)     count  = atoi( argv[ ++i ] );
+    }
+
+    simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_simSetBusSpeed( _LIGHTRANGER3_I2C_BUS.devPath, busHz );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_MEASUREMENT, measUs );
+}
+
+int main(int argc, char **argv)
+{
+    static const char *names[] = { "exp_fast_short", "balanced", "exp_long_range" };
+    const T_lightranger3_profile *profiles[ 3 ];
+    T_phase  sw, reinit, meas;
+    uint32_t errors;
+    uint32_t i, p;
+
+    profiles[ 0 ] = &_LIGHTRANGER3_PROFILE_EXP_FAST_SHORT;
+    profiles[ 1 ] = &_LIGHTRANGER3_PROFILE_BALANCED;
+    profiles[ 2 ] = &_LIGHTRANGER3_PROFILE_EXP_LONG_RANGE;
+
+    systemInit( argc, argv );
+    lightranger3_i2cDriverInit( lightranger3_simGpioObj( simDev ), (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS,
+                                _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_setTickSource( lightranger3_simTickUs );
+    if (lightranger3_init() != 0)
+    {
+        printf( "{\"error\": \"init failed\"}\n" );
+        return 1;
+    }
+
+    printf( "[\n" );
+    for (p = 0; p < 3; p++)
+    {
+        errors = 0;
+
+        // Full reload of the profile as a reference
+        errors += lightranger3_setProfile( profiles[ p ] );
+        lightranger3_invalidateCache();
+        phaseBegin();
+        errors += lightranger3_init();
+        phaseEnd( &reinit );
+
+        // Runtime switch from the init default
+        errors += lightranger3_setProfile( &_LIGHTRANGER3_PROFILE_BALANCED );
+        phaseBegin();
+        errors += lightranger3_setProfile( profiles[ p ] );
+        phaseEnd( &sw );
+
+        phaseBegin();
+        for (i = 0; i < count; i++)
+        {
+            errors += lightranger3_takeSingleMeasurement();
+        }
+        phaseEnd( &meas );
+
+        printf( "  {\"profile\": \"%s\", \"cmd_config\": [\"0x%04X\", \"0x%04X\"],\n",
+                names[ p ], profiles[ p ]->cmdConfig[ 0 ], profiles[ p ]->cmdConfig[ 1 ] );
+        printf( "   \"switch\": {\"transactions\": %u, \"bytes\": %u, \"us\": %llu},\n",
+                sw.transfers, sw.bytes, (unsigned long long)sw.us );
+        printf( "   \"reinit\": {\"transactions\": %u, \"bytes\": %u, \"us\": %llu},\n",
+                reinit.transfers, reinit.bytes, (unsigned long long)reinit.us );
+        printf( "   \"count\": %u, \"sim_meas_per_s\": %.1f, \"sim_us_per_meas\": %.1f, \"errors\": %u}%s\n",
+                count, count * 1e6 / meas.us, (double)meas.us / count, errors, p < 2 ? "," : "" );
+    }
+    printf( "]\n" );
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+Address provisioning example for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_provision.c \
+        ../../../library/__lightranger3_driver.c -o lightranger3_provision
+
+---
+
+Description :
+
+Puts identical simulated boards, all answering on 0x4C, on one virtual bus
+with one enable line each. lightranger3_provision moves them to 0x50,
+0x51, ..., lightranger3_enumerate then scans 0x08 - 0x77 and every sensor
+found is initialized and takes one measurement.
+
+Prints JSON with the addresses found and the bus time of both steps, exits
+with 1 if any board is missing or fails to measure.
+
+Options :
+
+    --boards N       number of boards (default 8, at most 16)
+    --first N        address of board 0 (default 0x50)
+    --bus-hz N       SCL frequency (default 400000)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_sim.h"
+
+#define MAX_BOARDS      16
+
+uint32_t boards   = 8;
+uint32_t first    = 0x50;
+uint32_t busHz    = 400000;
+
+uint8_t              simDev[ MAX_BOARDS ];
+T_lightranger3_dev   board[ MAX_BOARDS ];
+T_lightranger3_dev  *boardList[ MAX_BOARDS ];
+T_lightranger3_dev   found[ MAX_BOARDS ];
+
+void boardEnable(uint8_t index, uint8_t state)
+{
+    lightranger3_simSetEnable( simDev[ index ], state );
+}
+
+void systemInit(int argc, char **argv)
+{
+    uint32_t n;
+    int      i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--boards" ) && i + 1 < argc)         boards = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--first" ) && i + 1 < argc)     first  = strtol( argv[ ++i ], 0, 0 );
+        else if (!strcmp( argv[ i ], "--bus-hz" ) && i + 1 < argc)    busHz  = atoi( argv[ ++i ] );
+    }
+    if (boards > MAX_BOARDS)
+    {
+        boards = MAX_BOARDS;
+    }
+
+    lightranger3_simSetBusSpeed( _LIGHTRANGER3_I2C_BUS.devPath, busHz );
+    for (n = 0; n < boards; n++)
+    {
+        simDev[ n ] = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, _LIGHTRANGER3_DEFAULT_ADDRESS );
+        lightranger3_devI2cInit( &board[ n ], lightranger3_simGpioObj( simDev[ n ] ),
+                                 (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS, _LIGHTRANGER3_DEFAULT_ADDRESS );
+        boardList[ n ] = &board[ n ];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t t0;
+    uint64_t provisionUs, enumerateUs;
+    uint8_t  provisioned, nFound;
+    uint8_t  failed = 0;
+    uint8_t  i;
+
+    systemInit( argc, argv );
+
+    t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    provisioned = lightranger3_provision( boardList, boards, first, boardEnable );
+    provisionUs = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0;
+
+    t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    nFound = lightranger3_enumerate( found, MAX_BOARDS, lightranger3_simGpioObj( simDev[ 0 ] ),
+                                     (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS, 0x08, 0x77 );
+    enumerateUs = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0;
+
+    printf( "{\n" );
+    printf( "  \"boards\": %u, \"provisioned\": %u, \"provision_us\": %llu,\n",
+            boards, provisioned, (unsigned long long)provisionUs );
+    printf( "  \"found\": %u, \"enumerate_us\": %llu,\n", nFound, (unsigned long long)enumerateUs );
+    printf( "  \"sensors\": [" );
+    for (i = 0; i < nFound; i++)
+    {
+        // Measure through the provisioned instance, it carries the board's own INT pin
+        if (found[ i ].slaveAddress != first + i
+            || lightranger3_devInit( &board[ i ] ) != 0
+            || lightranger3_devTakeSingleMeasurement( &board[ i ] ) != 0)
+        {
+            failed++;
+        }
+        printf( "%s{\"address\": \"0x%02X\", \"id\": \"0x%04X\", \"distance\": %u}",
+                i ? ", " : "", found[ i ].slaveAddress, lightranger3_devGetDeviceID( &found[ i ] ),
+                lightranger3_devGetDistance( &board[ i ] ) );
+    }
+    printf( "],\n" );
+    printf( "  \"failed\": %u\n}\n", failed );
+
+    return (provisioned != boards || nFound != boards || failed != 0);
+}
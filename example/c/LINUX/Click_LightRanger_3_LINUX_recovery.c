@@ -0,0 +1,181 @@
+/*
+Measurement recovery test for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_recovery.c \
+        ../../../library/__lightranger3_driver.c -o lightranger3_recovery
+
+---
+
+Description :
+
+Moves a simulated sensor off its power up address, then injects each of
+the simulator faults in turn and measures through
+lightranger3_devMeasureWithRecovery. Every fault has one cheapest tier that
+clears it:
+
+- error_code   error code on the next result     retry
+- stuck_meas   measure command ignored           on
+- stuck_on     measure and on commands ignored   cycle
+- hung         every command but reset ignored   reset
+
+For every fault it prints one JSON object with the attempts and recoveries
+per tier, the recovery time percentiles of the expected tier and whether
+every round recovered on the expected tier. A last object compares the
+reset, now polled on DEV_STATUS, with the fixed 100 ms sleep it replaces.
+Times are virtual microseconds of the simulated bus. Exits with 1 when a
+round recovers on another tier or not at all.
+
+Options :
+
+    --rounds N       faults injected per type (default 200)
+    --meas-us N      sensor integration time (default 2000)
+    --timeout-us N   measurement timeout (default 10000)
+    --reset-us N     sensor boot time after a reset (default 10000)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_sim.h"
+
+#define SENSOR_ADDRESS  0x41
+
+uint32_t rounds    = 200;
+uint32_t measUs    = 2000;
+uint32_t timeoutUs = 10000;
+uint32_t resetUs   = 10000;
+
+uint8_t            simDev;
+T_lightranger3_dev sensor;
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--rounds" ) && i + 1 < argc)           rounds    = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--meas-us" ) && i + 1 < argc)     measUs    = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--timeout-us" ) && i + 1 < argc)  timeoutUs = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--reset-us" ) && i + 1 < argc)    resetUs   = atoi( argv[ ++i ] );
+    }
+
+    simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_MEASUREMENT, measUs );
+    lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_RESET, resetUs );
+}
+
+// Upper edge of the bucket holding the given share of the recoveries, at most the maximum
+uint32_t percentileUs(const uint16_t *bucket, uint32_t total, uint32_t maxUs, uint32_t permille)
+{
+    uint32_t seen = 0;
+    uint32_t edge;
+    uint8_t  b;
+
+    for (b = 0; b < _LIGHTRANGER3_RECOVER_BUCKETS; b++)
+    {
+        seen += bucket[ b ];
+        if (seen != 0 && seen * 1000ULL >= (uint64_t)total * permille)
+        {
+            edge = b == _LIGHTRANGER3_RECOVER_BUCKETS - 1 ? maxUs : _LIGHTRANGER3_RECOVER_LOWER( b + 1 ) - 1;
+            return edge < maxUs ? edge : maxUs;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const char    *names[] = { "error_code", "stuck_meas", "stuck_on", "hung" };
+    static const char    *tiers[] = { "retry", "on", "cycle", "reset" };
+    static const uint8_t faults[] = { _LIGHTRANGER3_SIM_FAULT_ERROR_CODE, _LIGHTRANGER3_SIM_FAULT_STUCK_MEAS,
+                                      _LIGHTRANGER3_SIM_FAULT_STUCK_ON, _LIGHTRANGER3_SIM_FAULT_HUNG };
+    T_lightranger3_recovery rec;
+    T_lightranger3_simStats stats;
+    uint64_t t0, resetTime;
+    uint32_t errors, wrong, resets;
+    uint32_t i, f, t;
+    uint8_t  match;
+    int      status = 0;
+
+    systemInit( argc, argv );
+    lightranger3_setTickSource( lightranger3_simTickUs );
+    lightranger3_devI2cInit( &sensor, lightranger3_simGpioObj( simDev ), (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS,
+                             _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_devSetTimeout( &sensor, _LIGHTRANGER3_MEASUREMENT_MODE, timeoutUs );
+    if (lightranger3_devSetAddress( &sensor, SENSOR_ADDRESS ) != 0 || lightranger3_devInit( &sensor ) != 0)
+    {
+        printf( "{\"error\": \"init failed\"}\n" );
+        return 1;
+    }
+
+    printf( "[\n" );
+    for (f = 0; f < 4; f++)
+    {
+        lightranger3_recoveryInit( &rec, _LIGHTRANGER3_RECOVER_RESET );
+        errors = 0;
+        for (i = 0; i < rounds; i++)
+        {
+            lightranger3_simInjectFault( simDev, faults[ f ], 1 );
+            errors += lightranger3_devMeasureWithRecovery( &sensor, &rec ) != 0;
+            // The next measurement must go through without any tier
+            errors += lightranger3_devMeasureWithRecovery( &sensor, &rec ) != 0;
+        }
+        wrong = rec.failed;
+        for (t = 0; t < _LIGHTRANGER3_RECOVER_TIERS; t++)
+        {
+            if (t != f)
+            {
+                wrong += rec.recovered[ t ];
+            }
+        }
+        match = (wrong == 0 && rec.recovered[ f ] == rounds && errors == 0);
+        if (!match)
+        {
+            status = 1;
+        }
+
+        printf( "  {\"fault\": \"%s\", \"expected_tier\": \"%s\", \"rounds\": %u,\n", names[ f ], tiers[ f ], rounds );
+        printf( "   \"attempts\": [%u, %u, %u, %u], \"recovered\": [%u, %u, %u, %u], \"failed\": %u,\n",
+                rec.attempts[ 0 ], rec.attempts[ 1 ], rec.attempts[ 2 ], rec.attempts[ 3 ],
+                rec.recovered[ 0 ], rec.recovered[ 1 ], rec.recovered[ 2 ], rec.recovered[ 3 ], rec.failed );
+        printf( "   \"recovery_us\": {\"p50\": %u, \"p99\": %u, \"max\": %u}, \"errors\": %u, \"match\": %s},\n",
+                percentileUs( rec.bucket[ f ], rec.recovered[ f ], rec.maxUs[ f ], 500 ),
+                percentileUs( rec.bucket[ f ], rec.recovered[ f ], rec.maxUs[ f ], 990 ),
+                rec.maxUs[ f ], errors, match ? "true" : "false" );
+    }
+
+    // Reset on its own against the sleep it replaces
+    lightranger3_simGetStats( simDev, &stats );
+    resets = stats.resets;
+    t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    errors    = lightranger3_devSoftReset( &sensor ) != 0;
+    resetTime = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0;
+    errors   += lightranger3_devInit( &sensor ) != 0;
+    errors += lightranger3_devTakeSingleMeasurement( &sensor ) != 0;
+    lightranger3_simGetStats( simDev, &stats );
+    if (errors != 0 || sensor.slaveAddress != SENSOR_ADDRESS)
+    {
+        status = 1;
+    }
+
+    printf( "  {\"soft_reset_us\": %llu, \"fixed_sleep_us\": 100000, \"resets\": %u, \"address\": \"0x%02X\", \"errors\": %u}\n",
+            (unsigned long long)resetTime, stats.resets - resets, sensor.slaveAddress, errors );
+    printf( "]\n" );
+
+    return status;
+}
@@ -0,0 +1,151 @@
+/*
+Sample ring stress test for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_ring.c \
+        ../../../library/__lightranger3_driver.c -lpthread -o lightranger3_ring
+
+---
+
+Description :
+
+Runs a producer and a consumer thread on one T_lightranger3_ring. The
+producer pushes numbered samples as fast as it can, the consumer pops
+them, so the ring runs full and empty over and over on two cores.
+
+Every sample carries its number in the timestamp and values derived from
+it in distance, confidence and error code. The consumer checks that
+numbers only increase, that no sample is torn, and that the numbers it
+skipped add up to the overflows the producer counted. Prints JSON, exits
+with 1 on any violation.
+
+Options :
+
+    --samples N      samples pushed (default 10000000)
+    --spin N         consumer busy loop per pop, slows it down (default 0)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "__lightranger3_driver.h"
+
+uint32_t samples = 10000000;
+uint32_t spin    = 0;
+
+T_lightranger3_ring ring;
+volatile int        producerDone = 0;
+
+uint32_t pushed   = 0;
+uint32_t rejected = 0;
+
+void fillSample(T_lightranger3_sample *s, uint32_t n)
+{
+    s->timestamp       = n;
+    s->distance        = n & 0x07FF;
+    s->confidenceValue = (n >> 11) & 0x07FF;
+    s->errorCode       = (uint8_t)(n * 7) & 0x03;
+}
+
+void* producer(void *arg)
+{
+    T_lightranger3_sample s;
+    uint32_t n;
+
+    (void)arg;
+    for (n = 1; n <= samples; n++)
+    {
+        fillSample( &s, n );
+        if (lightranger3_ringPush( &ring, &s ) != 0)
+        {
+            rejected++;
+            // Lets the consumer in on a single core host
+            if ((rejected & 0xFF) == 0)
+            {
+                sched_yield();
+            }
+        }
+        else
+        {
+            pushed++;
+        }
+    }
+    __atomic_store_n( &producerDone, 1, __ATOMIC_RELEASE );
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    T_lightranger3_sample s, expect;
+    pthread_t thread;
+    uint32_t  popped  = 0;
+    uint32_t  skipped = 0;
+    uint32_t  order   = 0;
+    uint32_t  torn    = 0;
+    uint32_t  last    = 0;
+    volatile uint32_t k;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--samples" ) && i + 1 < argc)    samples = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--spin" ) && i + 1 < argc)  spin    = atoi( argv[ ++i ] );
+    }
+
+    lightranger3_ringInit( &ring );
+    pthread_create( &thread, 0, producer, 0 );
+    for (;;)
+    {
+        if (lightranger3_ringPop( &ring, &s ) == 0)
+        {
+            if (__atomic_load_n( &producerDone, __ATOMIC_ACQUIRE ) && lightranger3_ringCount( &ring ) == 0)
+            {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        popped++;
+        if (s.timestamp <= last)
+        {
+            order++;
+        }
+        else
+        {
+            skipped += s.timestamp - last - 1;
+        }
+        fillSample( &expect, s.timestamp );
+        if (s.distance != expect.distance || s.confidenceValue != expect.confidenceValue
+            || s.errorCode != expect.errorCode)
+        {
+            torn++;
+        }
+        last = s.timestamp;
+        for (k = 0; k < spin; k++)
+        {
+        }
+    }
+    pthread_join( thread, 0 );
+    // Samples rejected after the last one popped are not gaps
+    skipped += samples - last;
+
+    printf( "{\"samples\": %u, \"pushed\": %u, \"popped\": %u, \"overflows\": %u, \"rejected\": %u,\n",
+            samples, pushed, popped, ring.overflows, rejected );
+    printf( " \"skipped\": %u, \"out_of_order\": %u, \"torn\": %u}\n", skipped, order, torn );
+
+    // overflows is 16 bit, the rejection count of the producer is exact
+    return (order != 0 || torn != 0 || popped != pushed || skipped != rejected
+            || ring.overflows != (uint16_t)rejected);
+}
@@ -0,0 +1,263 @@
+/*
+Multi-sensor scheduler benchmark for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_sched.c \
+        ../../../library/__lightranger3_driver.c -lm -o lightranger3_sched
+
+    With HAL call counters, adds the HAL calls and bytes per scheduled sample :
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -D__HAL_I2C_STATS__ -I../../../library Click_LightRanger_3_LINUX_sched.c \
+        ../../../library/__lightranger3_driver.c -lm -o lightranger3_sched
+
+---
+
+Description :
+
+Puts 1 to 16 simulated sensors on one virtual bus and, for every sensor
+count, measures
+
+- sequential  - lightranger3_devTakeSingleMeasurement on each sensor in turn
+- scheduled   - lightranger3_schedService keeping all sensors integrating
+
+Prints one JSON object per sensor count with the aggregate samples per
+second of both and, for the scheduler, the jitter of the sample interval of
+each sensor (standard deviation, averaged over the sensors and worst one).
+
+Options :
+
+    --bus-hz N       SCL frequency (default 400000)
+    --meas-us N      sensor integration time (default 2000)
+    --jitter-us N    integration time jitter (default 200)
+    --samples N      samples per sensor and run (default 200)
+    --max N          largest sensor count (default 16)
+    --int            wait on INT pin instead of polling ICSR
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_sim.h"
+
+#define MAX_SENSORS     16
+
+// HAL delay, advances the simulated bus clock
+void Delay_10us();
+
+uint32_t busHz    = 400000;
+uint32_t measUs   = 2000;
+uint32_t jitterUs = 200;
+uint32_t samples  = 200;
+uint32_t maxCount = MAX_SENSORS;
+uint8_t  useInt   = 0;
+
+T_lightranger3_dev   sensor[ MAX_SENSORS ];
+T_lightranger3_dev  *sensorList[ MAX_SENSORS ];
+T_lightranger3_sched sched;
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--bus-hz" ) && i + 1 < argc)         busHz    = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--meas-us" ) && i + 1 < argc)   measUs   = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--jitter-us" ) && i + 1 < argc) jitterUs = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--samples" ) && i + 1 < argc)   samples  = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--max" ) && i + 1 < argc)       maxCount = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--int" ))                       useInt   = 1;
+    }
+    if (maxCount > MAX_SENSORS)
+    {
+        maxCount = MAX_SENSORS;
+    }
+}
+
+uint8_t sensorsInit(uint8_t count)
+{
+    uint8_t i;
+    uint8_t simDev;
+
+    lightranger3_simReset();
+    lightranger3_simSetBusSpeed( _LIGHTRANGER3_I2C_BUS.devPath, busHz );
+    for (i = 0; i < count; i++)
+    {
+        simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, 0x40 + i );
+        lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_MEASUREMENT, measUs );
+        lightranger3_simSetJitter( simDev, jitterUs );
+
+        lightranger3_devI2cInit( &sensor[ i ], lightranger3_simGpioObj( simDev ),
+                                 (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS, 0x40 + i );
+        if (useInt)
+        {
+            lightranger3_devSetReadyMode( &sensor[ i ], _LIGHTRANGER3_READY_INT );
+        }
+        if (lightranger3_devInit( &sensor[ i ] ) != 0)
+        {
+            return 1;
+        }
+        sensorList[ i ] = &sensor[ i ];
+    }
+    return 0;
+}
+
+double runSequential(uint8_t count, uint32_t *errors)
+{
+    uint64_t t0;
+    uint32_t n;
+    uint8_t  i;
+
+    t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    for (n = 0; n < samples; n++)
+    {
+        for (i = 0; i < count; i++)
+        {
+            *errors += lightranger3_devTakeSingleMeasurement( &sensor[ i ] ) != 0;
+        }
+    }
+    return (double)count * samples * 1e6 / (lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0);
+}
+
+double runScheduled(uint8_t count, uint32_t *errors, double *jitterMean, double *jitterMax)
+{
+    uint64_t t0, now;
+    uint64_t last[ MAX_SENSORS ];
+    uint32_t got[ MAX_SENSORS ];
+    double   sum[ MAX_SENSORS ];
+    double   sumSq[ MAX_SENSORS ];
+    double   d, mean, sd;
+    uint32_t done;
+    uint8_t  idle;
+    uint8_t  idx;
+    T_lightranger3_sample sample;
+    uint8_t  i;
+
+    memset( got, 0, sizeof( got ) );
+    memset( sum, 0, sizeof( sum ) );
+    memset( sumSq, 0, sizeof( sumSq ) );
+
+    lightranger3_schedInit( &sched, sensorList, count );
+    t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    for (i = 0; i < count; i++)
+    {
+        last[ i ] = t0;
+    }
+    lightranger3_schedStart( &sched );
+
+    done = 0;
+    idle = 0;
+    while (done < count)
+    {
+        idx = lightranger3_schedService( &sched, &sample );
+        if (idx == 0xFF)
+        {
+            // A whole round without results, the application would sleep here
+            if (++idle >= count)
+            {
+                Delay_10us();
+                idle = 0;
+            }
+            continue;
+        }
+        idle = 0;
+        if (got[ idx ] == samples)
+        {
+            continue;
+        }
+        *errors += sample.errorCode != 0;
+        now = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+        if (got[ idx ] != 0)
+        {
+            d = (double)(now - last[ idx ]);
+            sum[ idx ]   += d;
+            sumSq[ idx ] += d * d;
+        }
+        last[ idx ] = now;
+        if (++got[ idx ] == samples)
+        {
+            done++;
+        }
+    }
+    now = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    lightranger3_schedStop( &sched );
+
+    *jitterMean = 0;
+    *jitterMax  = 0;
+    for (i = 0; i < count; i++)
+    {
+        mean = sum[ i ] / (samples - 1);
+        sd   = sumSq[ i ] / (samples - 1) - mean * mean;
+        sd   = sd > 0 ? sqrt( sd ) : 0;
+        *jitterMean += sd / count;
+        if (sd > *jitterMax)
+        {
+            *jitterMax = sd;
+        }
+    }
+    return (double)count * samples * 1e6 / (now - t0);
+}
+
+int main(int argc, char **argv)
+{
+    double   seqRate, schedRate, jitterMean, jitterMax;
+    uint32_t errors;
+    uint8_t  count;
+#ifdef __HAL_I2C_STATS__
+    T_lightranger3_busStats bus;
+#endif
+
+    systemInit( argc, argv );
+    if (samples < 2)
+    {
+        samples = 2;
+    }
+
+    printf( "[\n" );
+    for (count = 1; count <= maxCount; count++)
+    {
+        errors = 0;
+        if (sensorsInit( count ) != 0)
+        {
+            printf( "{\"error\": \"init failed\", \"sensors\": %u}\n]\n", count );
+            return 1;
+        }
+        seqRate   = runSequential( count, &errors );
+#ifdef __HAL_I2C_STATS__
+        lightranger3_resetBusStats();
+#endif
+        schedRate = runScheduled( count, &errors, &jitterMean, &jitterMax );
+#ifdef __HAL_I2C_STATS__
+        lightranger3_getBusStats( 0, &bus );
+#endif
+
+        printf( "  {\"sensors\": %u, \"bus_hz\": %u, \"meas_us\": %u, \"ready\": \"%s\", "
+                "\"sequential_per_s\": %.1f, \"scheduled_per_s\": %.1f, "
+                "\"jitter_us\": {\"mean\": %.1f, \"max\": %.1f}, \"errors\": %u",
+                count, busHz, measUs, useInt ? "int" : "poll",
+                seqRate, schedRate, jitterMean, jitterMax, errors );
+#ifdef __HAL_I2C_STATS__
+        printf( ", \"hal_per_sample\": {\"calls\": %.2f, \"bytes\": %.2f}",
+                (double)(bus.writes + bus.reads) / (count * samples),
+                (double)(bus.bytesWritten + bus.bytesRead) / (count * samples) );
+#endif
+        printf( "}%s\n", count < maxCount ? "," : "" );
+    }
+    printf( "]\n" );
+
+    return 0;
+}
@@ -0,0 +1,257 @@
+/*
+Acquisition service benchmark for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_service.c \
+        ../../../library/__lightranger3_service.c ../../../library/__lightranger3_shm.c \
+        ../../../library/__lightranger3_driver.c -lpthread -o lightranger3_service
+
+---
+
+Description :
+
+Runs the acquisition service over 1 to N simulated buses, one worker thread
+per bus, with consumer threads popping samples from all bus queues. For
+every bus count it prints one JSON object with
+
+- delivered_per_s - samples per wall clock second popped by the consumers
+- drop_rate       - share of the samples lost to a full queue
+- virtual_per_s   - samples per second of simulated bus time, all buses
+- latency_ns      - push to pop latency percentiles of the queues
+
+By default every simulated bus is paced to wall clock time
+(lightranger3_simSetRealtime), so workers publish at the rate real sensors
+would and drop_rate is the loss a deployment would see. With --unpaced the
+workers produce as fast as the CPU allows; that stresses the queues, and
+on few CPUs the workers outrun the consumers and most samples are dropped.
+
+Options :
+
+    --buses N        largest bus count (default 4, at most 8)
+    --sensors N      sensors per bus (default 4)
+    --samples N      samples published per bus (default 2000)
+    --consumers N    consumer threads (default 2, at most 8)
+    --bus-hz N       SCL frequency (default 400000)
+    --meas-us N      sensor integration time (default 2000)
+    --int            wait on INT pin instead of polling ICSR
+    --unpaced        run the simulated buses as fast as the host allows
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include "Click_LightRanger_3_types.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_service.h"
+#include "__lightranger3_sim.h"
+
+#define MAX_SENSORS     16
+#define MAX_CONSUMERS   8
+
+const T_LIGHTRANGER3_LINUX_I2C _LIGHTRANGER3_I2C_BUSES[ _LIGHTRANGER3_SVC_MAX_BUSES ] =
+{
+    { "/dev/i2c-1" }, { "/dev/i2c-2" }, { "/dev/i2c-3" }, { "/dev/i2c-4" },
+    { "/dev/i2c-5" }, { "/dev/i2c-6" }, { "/dev/i2c-7" }, { "/dev/i2c-8" }
+};
+
+typedef struct
+{
+    pthread_t   thread;
+    uint64_t    *lat;
+    uint32_t    count;
+    uint32_t    capacity;
+    uint32_t    errors;
+
+}T_consumer;
+
+uint32_t maxBuses  = 4;
+uint32_t sensors   = 4;
+uint32_t samples   = 2000;
+uint32_t consumers = 2;
+uint32_t busHz     = 400000;
+uint32_t measUs    = 2000;
+uint8_t  useInt    = 0;
+uint8_t  paced     = 1;
+
+T_lightranger3_svc  svc;
+T_lightranger3_dev  sensor[ _LIGHTRANGER3_SVC_MAX_BUSES ][ MAX_SENSORS ];
+T_lightranger3_dev  *sensorList[ _LIGHTRANGER3_SVC_MAX_BUSES ][ MAX_SENSORS ];
+T_consumer          consumer[ MAX_CONSUMERS ];
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--buses" ) && i + 1 < argc)          maxBuses  = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--sensors" ) && i + 1 < argc)   sensors   = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--samples" ) && i + 1 < argc)   samples   = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--consumers" ) && i + 1 < argc) consumers = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--bus-hz" ) && i + 1 < argc)    busHz     = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--meas-us" ) && i + 1 < argc)   measUs    = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--int" ))                       useInt    = 1;
+        else if (!strcmp( argv[ i ], "--unpaced" ))                   paced     = 0;
+    }
+    if (maxBuses > _LIGHTRANGER3_SVC_MAX_BUSES) maxBuses  = _LIGHTRANGER3_SVC_MAX_BUSES;
+    if (sensors > MAX_SENSORS)                  sensors   = MAX_SENSORS;
+    if (consumers > MAX_CONSUMERS)              consumers = MAX_CONSUMERS;
+    if (consumers == 0)                         consumers = 1;
+}
+
+void* consumerTask(void *arg)
+{
+    T_consumer *c = (T_consumer*)arg;
+    T_lightranger3_svcSample s;
+    uint8_t cursor = 0;
+    uint8_t done;
+
+    for (;;)
+    {
+        // Workers push before they flag done, so an empty pass after done means drained
+        done = lightranger3_svcDone( &svc );
+        if (lightranger3_svcPopAny( &svc, &cursor, &s ))
+        {
+            if (c->count < c->capacity)
+            {
+                c->lat[ c->count ] = lightranger3_svcNowNs() - s.publishNs;
+            }
+            c->count++;
+            c->errors += s.sample.errorCode != 0;
+            continue;
+        }
+        if (done)
+        {
+            break;
+        }
+        sched_yield();
+    }
+    return 0;
+}
+
+int cmpU64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t t0, wallNs;
+    uint64_t *all;
+    uint32_t nLat, published, dropped, initErrors, errors;
+    uint32_t b, i, k;
+    double   virtualRate;
+    uint8_t  simDev;
+    uint8_t  nBuses;
+
+    systemInit( argc, argv );
+
+    printf( "[\n" );
+    for (nBuses = 1; nBuses <= maxBuses; nBuses++)
+    {
+        lightranger3_simReset();
+        lightranger3_svcInit( &svc );
+        for (b = 0; b < nBuses; b++)
+        {
+            lightranger3_simSetBusSpeed( _LIGHTRANGER3_I2C_BUSES[ b ].devPath, busHz );
+            for (i = 0; i < sensors; i++)
+            {
+                simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUSES[ b ].devPath, 0x40 + i );
+                lightranger3_simSetLatency( simDev, _LIGHTRANGER3_SIM_LAT_MEASUREMENT, measUs );
+                lightranger3_devI2cInit( &sensor[ b ][ i ], lightranger3_simGpioObj( simDev ),
+                                         (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUSES[ b ], 0x40 + i );
+                if (useInt)
+                {
+                    lightranger3_devSetReadyMode( &sensor[ b ][ i ], _LIGHTRANGER3_READY_INT );
+                }
+                sensorList[ b ][ i ] = &sensor[ b ][ i ];
+            }
+            lightranger3_svcAddBus( &svc, sensorList[ b ], sensors, samples );
+            lightranger3_simSetRealtime( _LIGHTRANGER3_I2C_BUSES[ b ].devPath, paced );
+        }
+
+        for (k = 0; k < consumers; k++)
+        {
+            consumer[ k ].capacity = nBuses * samples;
+            consumer[ k ].count    = 0;
+            consumer[ k ].errors   = 0;
+            consumer[ k ].lat      = malloc( consumer[ k ].capacity * sizeof( uint64_t ) );
+        }
+
+        t0 = lightranger3_svcNowNs();
+        lightranger3_svcStart( &svc );
+        for (k = 0; k < consumers; k++)
+        {
+            pthread_create( &consumer[ k ].thread, 0, consumerTask, &consumer[ k ] );
+        }
+        for (k = 0; k < consumers; k++)
+        {
+            pthread_join( consumer[ k ].thread, 0 );
+        }
+        wallNs = lightranger3_svcNowNs() - t0;
+        lightranger3_svcStop( &svc );
+
+        published   = 0;
+        dropped     = 0;
+        initErrors  = 0;
+        virtualRate = 0;
+        for (b = 0; b < nBuses; b++)
+        {
+            published   += svc.bus[ b ].published;
+            dropped     += svc.bus[ b ].dropped;
+            initErrors  += svc.bus[ b ].initErrors;
+            virtualRate += (svc.bus[ b ].published + svc.bus[ b ].dropped) * 1e6 / lightranger3_simTime( _LIGHTRANGER3_I2C_BUSES[ b ].devPath );
+        }
+
+        nLat   = 0;
+        errors = 0;
+        for (k = 0; k < consumers; k++)
+        {
+            nLat   += consumer[ k ].count;
+            errors += consumer[ k ].errors;
+        }
+        all = malloc( (nLat ? nLat : 1) * sizeof( uint64_t ) );
+        nLat = 0;
+        for (k = 0; k < consumers; k++)
+        {
+            memcpy( all + nLat, consumer[ k ].lat, consumer[ k ].count * sizeof( uint64_t ) );
+            nLat += consumer[ k ].count;
+            free( consumer[ k ].lat );
+        }
+        qsort( all, nLat, sizeof( uint64_t ), cmpU64 );
+
+        printf( "  {\"buses\": %u, \"sensors_per_bus\": %u, \"consumers\": %u, \"ready\": \"%s\", \"paced\": %s, "
+                "\"delivered_per_s\": %.0f, \"drop_rate\": %.4f, "
+                "\"published\": %u, \"consumed\": %u, \"dropped\": %u, \"init_errors\": %u, \"errors\": %u, "
+                "\"virtual_per_s\": %.1f, "
+                "\"latency_ns\": {\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}}%s\n",
+                nBuses, sensors, consumers, useInt ? "int" : "poll", paced ? "true" : "false",
+                nLat * 1e9 / wallNs, published + dropped ? (double)dropped / (published + dropped) : 0.0,
+                published, nLat, dropped, initErrors, errors,
+                virtualRate,
+                (unsigned long long)(nLat ? all[ nLat / 2 ] : 0),
+                (unsigned long long)(nLat ? all[ (uint64_t)nLat * 90 / 100 ] : 0),
+                (unsigned long long)(nLat ? all[ (uint64_t)nLat * 99 / 100 ] : 0),
+                (unsigned long long)(nLat ? all[ (uint64_t)nLat * 999 / 1000 ] : 0),
+                (unsigned long long)(nLat ? all[ nLat - 1 ] : 0),
+                nBuses < maxBuses ? "," : "" );
+        free( all );
+    }
+    printf( "]\n" );
+
+    return 0;
+}
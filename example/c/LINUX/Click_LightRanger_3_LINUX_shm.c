@@ -0,0 +1,304 @@
+/*
+Shared memory stream benchmark for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_shm.c \
+        ../../../library/__lightranger3_shm.c ../../../library/__lightranger3_driver.c \
+        -o lightranger3_shm
+
+---
+
+Description :
+
+Takes a batch of samples from a simulated sensor, then replays them into a
+shared memory ring at the rate the sensor delivered them while 1 to N
+reader processes map the ring read only and follow it. For every reader
+count it prints one JSON object with
+
+- delivered_per_s - records each reader received per second, mean over the
+                    readers
+- overrun_rate    - share of the published records a reader lost to being
+                    lapped, mean over the readers
+- write_per_s     - records published per second
+- aggregate_per_s - records read per second, all readers together
+- lost, overruns  - records skipped and times readers were lapped
+- max_lag         - largest writer lead seen by any reader
+- corrupt         - records whose payload did not match their sequence,
+                    must be 0
+
+--rate 0 publishes as fast as the writer can. Writer and readers share the
+CPUs of the host; with fewer CPUs than processes readers are descheduled
+for whole time slices and an unpaced writer laps them, so most records are
+lost and overrun_rate, not the write rate, is the result to look at.
+
+Options :
+
+    --readers N      largest reader count (default 8)
+    --records N      records published per run (default 2000)
+    --capacity N     ring size in records (default 4096)
+    --rate N         records per second, 0 for unpaced (default: the
+                     simulated sensor rate)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_shm.h"
+#include "__lightranger3_sim.h"
+
+#define SHM_NAME        "/lightranger3_bench"
+#define MAX_READERS     8
+#define BATCH           256
+
+typedef struct
+{
+    uint64_t    read;
+    uint64_t    lost;
+    uint64_t    maxLag;
+    uint64_t    corrupt;
+    uint64_t    ns;
+    uint32_t    overruns;
+
+}T_readerResult;
+
+typedef struct
+{
+    volatile uint32_t   ready;
+    T_readerResult      reader[ MAX_READERS ];
+
+}T_results;
+
+uint32_t maxReaders = MAX_READERS;
+uint32_t records    = 2000;
+uint32_t capacity   = 4096;
+int32_t  rate       = -1;
+
+T_lightranger3_sample batch[ BATCH ];
+T_results             *results;
+
+uint64_t nowNs()
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--readers" ) && i + 1 < argc)        maxReaders = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--records" ) && i + 1 < argc)   records    = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--capacity" ) && i + 1 < argc)  capacity   = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--rate" ) && i + 1 < argc)      rate       = atoi( argv[ ++i ] );
+    }
+    if (maxReaders > MAX_READERS) maxReaders = MAX_READERS;
+    if (maxReaders == 0)          maxReaders = 1;
+}
+
+uint8_t batchInit()
+{
+    uint64_t t0;
+    uint32_t i;
+    uint8_t  simDev;
+
+    simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_i2cDriverInit( lightranger3_simGpioObj( simDev ), (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS,
+                                _LIGHTRANGER3_DEFAULT_ADDRESS );
+    if (lightranger3_init() != 0)
+    {
+        return 1;
+    }
+    t0 = lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath );
+    for (i = 0; i < BATCH; i++)
+    {
+        batch[ i ].errorCode       = lightranger3_takeSingleMeasurement();
+        batch[ i ].distance        = lightranger3_getDistance();
+        batch[ i ].confidenceValue = lightranger3_getConfidenceValue();
+        batch[ i ].timestamp       = i;
+    }
+    // Publish at the rate the sensor produced the batch unless told otherwise
+    if (rate < 0)
+    {
+        rate = (int32_t)(BATCH * 1000000ULL / (lightranger3_simTime( _LIGHTRANGER3_I2C_BUS.devPath ) - t0));
+    }
+    return 0;
+}
+
+void readerTask(uint8_t index)
+{
+    T_lightranger3_shmReader reader;
+    T_lightranger3_shmRecord rec;
+    T_lightranger3_sample    *ref;
+    T_readerResult           *res = &results->reader[ index ];
+    uint64_t                 lag;
+    uint64_t                 t0;
+    uint8_t                  status;
+
+    if (lightranger3_shmOpen( &reader, SHM_NAME ) != 0)
+    {
+        _exit( 1 );
+    }
+    __atomic_add_fetch( &results->ready, 1, __ATOMIC_RELEASE );
+
+    // Wait for the first record so start-up does not count against the rate
+    while (lightranger3_shmLag( &reader ) == 0)
+    {
+        sched_yield();
+    }
+
+    t0 = nowNs();
+    for (;;)
+    {
+        lag = lightranger3_shmLag( &reader );
+        if (lag > res->maxLag)
+        {
+            res->maxLag = lag;
+        }
+        status = lightranger3_shmRead( &reader, &rec );
+        if (status == _LIGHTRANGER3_SHM_OK)
+        {
+            ref = &batch[ (rec.seq - 1) % BATCH ];
+            if (rec.distance != ref->distance || rec.confidenceValue != ref->confidenceValue
+                || rec.errorCode != ref->errorCode || rec.timestamp != ref->timestamp)
+            {
+                res->corrupt++;
+            }
+        }
+        else if (status == _LIGHTRANGER3_SHM_EMPTY)
+        {
+            if (lightranger3_shmClosed( &reader ) && lightranger3_shmLag( &reader ) == 0)
+            {
+                break;
+            }
+            sched_yield();
+        }
+    }
+    res->ns       = nowNs() - t0;
+    res->read     = reader.read;
+    res->lost     = reader.lost;
+    res->overruns = reader.overruns;
+    lightranger3_shmClose( &reader );
+    _exit( 0 );
+}
+
+int main(int argc, char **argv)
+{
+    T_lightranger3_shmWriter writer;
+    T_readerResult           sum;
+    struct timespec          ts;
+    uint64_t                 t0, now, writeNs, target;
+    uint32_t                 nReaders, i, k;
+    double                   readRate, overrunRate;
+
+    systemInit( argc, argv );
+    if (batchInit() != 0)
+    {
+        printf( "{\"error\": \"sensor init failed\"}\n" );
+        return 1;
+    }
+    results = mmap( 0, sizeof( T_results ), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+
+    printf( "[\n" );
+    for (nReaders = 1; nReaders <= maxReaders; nReaders++)
+    {
+        memset( results, 0, sizeof( T_results ) );
+        if (lightranger3_shmCreate( &writer, SHM_NAME, capacity ) != 0)
+        {
+            printf( "{\"error\": \"shm_open failed\"}\n]\n" );
+            return 1;
+        }
+        for (k = 0; k < nReaders; k++)
+        {
+            if (fork() == 0)
+            {
+                readerTask( k );
+            }
+        }
+        while (results->ready != nReaders)
+        {
+            sched_yield();
+        }
+
+        t0 = nowNs();
+        for (i = 0; i < records; i++)
+        {
+            lightranger3_shmPublish( &writer, &batch[ i % BATCH ], 0, 0 );
+            if (rate > 0)
+            {
+                // Sleep rather than spin, the readers may need this CPU
+                target = t0 + (uint64_t)(i + 1) * 1000000000ULL / rate;
+                now    = nowNs();
+                if (now < target)
+                {
+                    ts.tv_sec  = (target - now) / 1000000000ULL;
+                    ts.tv_nsec = (long)((target - now) % 1000000000ULL);
+                    nanosleep( &ts, 0 );
+                }
+            }
+        }
+        writeNs = nowNs() - t0;
+        lightranger3_shmDestroy( &writer );
+        for (k = 0; k < nReaders; k++)
+        {
+            wait( 0 );
+        }
+
+        memset( &sum, 0, sizeof( sum ) );
+        readRate    = 0;
+        overrunRate = 0;
+        for (k = 0; k < nReaders; k++)
+        {
+            sum.read     += results->reader[ k ].read;
+            sum.lost     += results->reader[ k ].lost;
+            sum.corrupt  += results->reader[ k ].corrupt;
+            sum.overruns += results->reader[ k ].overruns;
+            if (results->reader[ k ].maxLag > sum.maxLag)
+            {
+                sum.maxLag = results->reader[ k ].maxLag;
+            }
+            if (results->reader[ k ].ns != 0)
+            {
+                readRate += results->reader[ k ].read * 1e9 / results->reader[ k ].ns;
+            }
+            if (results->reader[ k ].read + results->reader[ k ].lost != 0)
+            {
+                overrunRate += (double)results->reader[ k ].lost / (results->reader[ k ].read + results->reader[ k ].lost);
+            }
+        }
+
+        printf( "  {\"readers\": %u, \"records\": %u, \"capacity\": %u, \"rate\": %d, "
+                "\"delivered_per_s\": %.0f, \"overrun_rate\": %.4f, \"write_per_s\": %.0f, "
+                "\"aggregate_per_s\": %.0f, \"read\": %llu, \"lost\": %llu, "
+                "\"overruns\": %u, \"max_lag\": %llu, \"corrupt\": %llu}%s\n",
+                nReaders, records, capacity, rate,
+                readRate / nReaders, overrunRate / nReaders, records * 1e9 / writeNs,
+                readRate, (unsigned long long)sum.read, (unsigned long long)sum.lost,
+                sum.overruns, (unsigned long long)sum.maxLag, (unsigned long long)sum.corrupt,
+                nReaders < maxReaders ? "," : "" );
+    }
+    printf( "]\n" );
+
+    return 0;
+}
@@ -0,0 +1,250 @@
+/*
+Binary telemetry benchmark for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : gcc
+
+    gcc -O2 -D__LIGHTRANGER3_SIM__ -I../../../library Click_LightRanger_3_LINUX_telemetry.c \
+        ../../../library/__lightranger3_decoder.c ../../../library/__lightranger3_driver.c \
+        -o lightranger3_telemetry
+
+---
+
+Description :
+
+Measures with a simulated sensor, encodes the samples into telemetry frames
+of 1, 2, 4 and 8 samples and decodes them again, once over a clean link and
+once over a link that flips bits and drops bytes. For every batch size it
+prints one JSON object with
+
+- bytes_per_sample  - wire bytes, against 21 for the text log line
+- per_s_9600, per_s_115200 - samples per second the link can carry
+- clean             - decoded samples identical to the encoded ones
+- noisy             - frames rejected by CRC, samples lost as reported by
+                      the decoder against the true loss, and samples that
+                      passed the CRC but do not match the original
+- encode_ns         - host time of lightranger3_frameAdd per sample
+
+Options :
+
+    --samples N      samples per run (default 100000)
+    --ber X          bit error rate of the noisy link (default 1e-4)
+    --drop X         byte drop rate of the noisy link (default 1e-4)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Click_LightRanger_3_types.h"
+#include "Click_LightRanger_3_config.h"
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_decoder.h"
+#include "__lightranger3_sim.h"
+
+// "Distance =" + IntToStr field + " mm" + line end
+#define TEXT_BYTES      21
+
+typedef struct
+{
+    T_lightranger3_sample   *ref;
+    uint32_t                refCount;
+    uint32_t                pos;
+    uint32_t                matched;
+    uint32_t                mismatched;
+    uint32_t                offset;
+
+}T_check;
+
+uint32_t samples = 100000;
+double   ber     = 1e-4;
+double   drop    = 1e-4;
+
+T_lightranger3_sample *source;
+uint8_t               *wire;
+uint8_t               *noisy;
+
+uint64_t nowNs()
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--samples" ) && i + 1 < argc)    samples = atoi( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--ber" ) && i + 1 < argc)   ber     = atof( argv[ ++i ] );
+        else if (!strcmp( argv[ i ], "--drop" ) && i + 1 < argc)  drop    = atof( argv[ ++i ] );
+    }
+}
+
+uint8_t sourceInit()
+{
+    uint8_t  simDev;
+    uint32_t i;
+
+    simDev = lightranger3_simAddDevice( _LIGHTRANGER3_I2C_BUS.devPath, _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_simSetJitter( simDev, 200 );
+    lightranger3_i2cDriverInit( lightranger3_simGpioObj( simDev ), (T_LIGHTRANGER3_P)&_LIGHTRANGER3_I2C_BUS,
+                                _LIGHTRANGER3_DEFAULT_ADDRESS );
+    lightranger3_setTickSource( lightranger3_simTickUs );
+    if (lightranger3_init() != 0)
+    {
+        return 1;
+    }
+    source = malloc( samples * sizeof( T_lightranger3_sample ) );
+    for (i = 0; i < samples; i++)
+    {
+        lightranger3_takeSingleMeasurement();
+        lightranger3_getSample( &source[ i ] );
+    }
+    return 0;
+}
+
+void checkSample(void *ctx, T_lightranger3_sample *sample)
+{
+    T_check  *c = (T_check*)ctx;
+    uint32_t i;
+
+    // Delivered samples must be an in-order subsequence of the source
+    for (i = c->pos; i < c->refCount && i < c->pos + 2048; i++)
+    {
+        if (c->ref[ i ].distance == sample->distance
+            && c->ref[ i ].confidenceValue == sample->confidenceValue
+            && c->ref[ i ].errorCode == sample->errorCode)
+        {
+            c->pos = i + 1;
+            c->matched++;
+            return;
+        }
+    }
+    c->mismatched++;
+}
+
+void cleanSample(void *ctx, T_lightranger3_sample *sample)
+{
+    T_check *c = (T_check*)ctx;
+
+    // The first delta saturates, after that rebuilt ticks keep a fixed offset
+    if (c->pos == 0)
+    {
+        c->offset = c->ref[ 0 ].timestamp - sample->timestamp;
+    }
+    if (c->pos < c->refCount
+        && c->ref[ c->pos ].distance == sample->distance
+        && c->ref[ c->pos ].confidenceValue == sample->confidenceValue
+        && c->ref[ c->pos ].errorCode == sample->errorCode
+        && c->ref[ c->pos ].timestamp == sample->timestamp + c->offset)
+    {
+        c->matched++;
+    }
+    else
+    {
+        c->mismatched++;
+    }
+    c->pos++;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint8_t batches[] = { 1, 2, 4, 8 };
+    T_lightranger3_frame    frame;
+    T_lightranger3_decoder  dec;
+    T_check                 clean, lossy;
+    uint64_t                t0, encodeNs;
+    uint32_t                wireLen, noisyLen;
+    uint32_t                i, j, b;
+    uint8_t                 len;
+    double                  bytesPerSample;
+
+    systemInit( argc, argv );
+    if (sourceInit() != 0)
+    {
+        printf( "{\"error\": \"sensor init failed\"}\n" );
+        return 1;
+    }
+    wire  = malloc( _LIGHTRANGER3_FRAME_LEN( 1 ) * samples );
+    noisy = malloc( _LIGHTRANGER3_FRAME_LEN( 1 ) * samples );
+    srand( 1 );
+
+    printf( "[\n" );
+    for (b = 0; b < sizeof( batches ); b++)
+    {
+        // Encode
+        wireLen = 0;
+        lightranger3_frameInit( &frame, batches[ b ] );
+        t0 = nowNs();
+        for (i = 0; i < samples; i++)
+        {
+            len = lightranger3_frameAdd( &frame, &source[ i ] );
+            memcpy( wire + wireLen, frame.buf, len );
+            wireLen += len;
+        }
+        len = lightranger3_frameFlush( &frame );
+        memcpy( wire + wireLen, frame.buf, len );
+        wireLen += len;
+        encodeNs = nowNs() - t0;
+        bytesPerSample = (double)wireLen / samples;
+
+        // Clean link
+        memset( &clean, 0, sizeof( clean ) );
+        clean.ref      = source;
+        clean.refCount = samples;
+        lightranger3_decoderInit( &dec );
+        lightranger3_decoderFeed( &dec, wire, wireLen, cleanSample, &clean );
+
+        printf( "  {\"batch\": %u, \"bytes_per_sample\": %.2f, \"text_bytes_per_sample\": %u, "
+                "\"per_s_9600\": %.0f, \"per_s_115200\": %.0f, \"encode_ns\": %.1f,\n",
+                batches[ b ], bytesPerSample, TEXT_BYTES,
+                960.0 / bytesPerSample, 11520.0 / bytesPerSample, (double)encodeNs / samples );
+        printf( "   \"clean\": {\"frames\": %u, \"samples\": %u, \"identical\": %u, \"crc_errors\": %u, \"lost\": %u},\n",
+                dec.frames, dec.samples, clean.matched, dec.crcErrors, dec.lostSamples );
+
+        // Noisy link, 8N1 bytes with bit flips and drops
+        noisyLen = 0;
+        for (i = 0; i < wireLen; i++)
+        {
+            if ((double)rand() / RAND_MAX < drop)
+            {
+                continue;
+            }
+            noisy[ noisyLen ] = wire[ i ];
+            for (j = 0; j < 8; j++)
+            {
+                if ((double)rand() / RAND_MAX < ber)
+                {
+                    noisy[ noisyLen ] ^= 1 << j;
+                }
+            }
+            noisyLen++;
+        }
+        memset( &lossy, 0, sizeof( lossy ) );
+        lossy.ref      = source;
+        lossy.refCount = samples;
+        lightranger3_decoderInit( &dec );
+        lightranger3_decoderFeed( &dec, noisy, noisyLen, checkSample, &lossy );
+
+        printf( "   \"noisy\": {\"ber\": %g, \"drop\": %g, \"frames\": %u, \"crc_errors\": %u, \"skipped_bytes\": %u, "
+                "\"lost_reported\": %u, \"lost_true\": %u, \"undetected\": %u}}%s\n",
+                ber, drop, dec.frames, dec.crcErrors, dec.skippedBytes,
+                dec.lostSamples, samples - lossy.matched, lossy.mismatched,
+                b + 1 < sizeof( batches ) ? "," : "" );
+    }
+    printf( "]\n" );
+
+    return 0;
+}
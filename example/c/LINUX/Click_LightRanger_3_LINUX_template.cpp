@@ -0,0 +1,291 @@
+/*
+Bus dispatch benchmark for LightRanger_3 Click
+
+    Date          : apr 2018.
+    Author        : Katarina Perendic
+
+Test configuration LINUX :
+
+    Host             : any Linux, no hardware needed
+    Compiler         : g++
+
+    g++ -O2 -I../../../library Click_LightRanger_3_LINUX_template.cpp -o lightranger3_template
+
+---
+
+Description :
+
+Runs the same lightranger3::Driver twice against an in-memory RFD77402
+register file that answers at once:
+
+- hal      - the bus policy calls through start / write / read function
+             pointers copied from a bus object at run time, the way hal_i2cMap
+             maps them on mikroSDK targets
+- template - the bus policy touches the register file directly and every
+             access inlines into the driver
+
+Both paths execute the same driver code and the same register traffic, so
+the difference is the cost of the indirect HAL calls. Prints one JSON object
+with ns per writeData, readData, measurement and init for each path and
+checks that both return the same distances.
+
+Options :
+
+    --loops N        register accesses per timing run (default 10000000)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "__lightranger3_driver.hpp"
+
+using namespace lightranger3;
+
+/* ------------------------------------------------ IN-MEMORY REGISTER FILE */
+
+struct Periph
+{
+    volatile uint8_t    regs[ 0x30 ];
+    volatile uint8_t    ptr;
+    volatile uint16_t   count;
+};
+
+static Periph periph;
+
+static inline void periphCommand(uint8_t cmd)
+{
+    uint16_t value;
+    uint8_t  i;
+
+    // Back at power up defaults, all zero but DEVICE_ID, DEV_STATUS in standby
+    if (cmd == CMD_SW_RESET)
+    {
+        for (i = 0; i < sizeof( periph.regs ); i++)
+        {
+            periph.regs[ i ] = 0x00;
+        }
+        periph.regs[ reg::DEVICE_ID ]     = 0x02;
+        periph.regs[ reg::DEVICE_ID + 1 ] = 0xAD;
+    }
+    else if (cmd == mode::STANDBY)     periph.regs[ reg::DEV_STATUS ] = 0x00;
+    else if (cmd == mode::OFF)         periph.regs[ reg::DEV_STATUS ] = 0x10;
+    else if (cmd == mode::ON)          periph.regs[ reg::DEV_STATUS ] = 0x18;
+    else if (cmd == mode::MEASUREMENT)
+    {
+        // Valid result, distance 100 - 1123 mm, confidence 1000
+        periph.count = periph.count + 1;
+        value = (uint16_t)(((100 + (periph.count & 0x3FF)) << 2) | 0x8000 | 0x0001);
+        periph.regs[ reg::RESULT ]            = (uint8_t)value;
+        periph.regs[ reg::RESULT + 1 ]        = (uint8_t)(value >> 8);
+        periph.regs[ reg::RESULT_CONFIG ]     = (uint8_t)(1000 << 4);
+        periph.regs[ reg::RESULT_CONFIG + 1 ] = (uint8_t)((1000 << 4) >> 8);
+        periph.regs[ reg::ICSR ]              = periph.regs[ reg::ICSR ] | 0x10;
+    }
+}
+
+static inline uint8_t periphWrite(uint8_t *buf, uint8_t n)
+{
+    uint8_t i;
+
+    periph.ptr = buf[ 0 ];
+    for (i = 1; i < n; i++)
+    {
+        if (periph.ptr == reg::CMD)
+        {
+            periphCommand( buf[ i ] );
+        }
+        else if (periph.ptr < sizeof( periph.regs ))
+        {
+            periph.regs[ periph.ptr ] = buf[ i ];
+        }
+        periph.ptr = periph.ptr + 1;
+    }
+    return 0;
+}
+
+static inline uint8_t periphRead(uint8_t *buf, uint8_t n)
+{
+    uint8_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        buf[ i ] = periph.ptr < sizeof( periph.regs ) ? periph.regs[ periph.ptr ] : 0;
+        // Reading the result clears the data ready flag
+        if (periph.ptr == reg::RESULT)
+        {
+            periph.regs[ reg::ICSR ] = periph.regs[ reg::ICSR ] & ~0x10;
+        }
+        periph.ptr = periph.ptr + 1;
+    }
+    return 0;
+}
+
+static void periphReset()
+{
+    memset( (void*)&periph, 0, sizeof( periph ) );
+    periph.regs[ reg::DEVICE_ID ]     = 0x02;
+    periph.regs[ reg::DEVICE_ID + 1 ] = 0xAD;
+}
+
+/* ------------------------------------------------------------ BUS POLICIES */
+
+// Direct: resolved at compile time
+struct DirectBus
+{
+    static uint8_t start() { return 0; }
+    static uint8_t write(uint8_t /* slave */, uint8_t *buf, uint8_t n, uint8_t /* end */) { return periphWrite( buf, n ); }
+    static uint8_t read(uint8_t /* slave */, uint8_t *buf, uint8_t n, uint8_t /* end */)  { return periphRead( buf, n ); }
+    static void    delay10us() {}
+};
+
+// HAL: bus object of function pointers, mapped at run time
+typedef uint8_t (*T_startFp)();
+typedef uint8_t (*T_xferFp)(uint8_t slave, uint8_t *buf, uint8_t n, uint8_t end);
+
+struct T_busObj
+{
+    T_startFp   i2cStart;
+    T_xferFp    i2cWrite;
+    T_xferFp    i2cRead;
+};
+
+__attribute__(( noinline )) static uint8_t busStart() { return 0; }
+__attribute__(( noinline )) static uint8_t busWrite(uint8_t /* slave */, uint8_t *buf, uint8_t n, uint8_t /* end */) { return periphWrite( buf, n ); }
+__attribute__(( noinline )) static uint8_t busRead(uint8_t /* slave */, uint8_t *buf, uint8_t n, uint8_t /* end */)  { return periphRead( buf, n ); }
+__attribute__(( noinline )) static uint8_t busFail() { return 1; }
+
+// Two bus objects like two mikroBUS sockets, picked at run time
+static const T_busObj busObj[ 2 ] =
+{
+    { busStart, busWrite, busRead },
+    { busFail,  busWrite, busRead }
+};
+
+static T_startFp fp_i2cStart;
+static T_xferFp  fp_i2cWrite;
+static T_xferFp  fp_i2cRead;
+
+static void hal_i2cMap(const T_busObj *obj)
+{
+    fp_i2cStart = obj->i2cStart;
+    fp_i2cWrite = obj->i2cWrite;
+    fp_i2cRead  = obj->i2cRead;
+}
+
+struct HalBus
+{
+    static uint8_t start() { return fp_i2cStart(); }
+    static uint8_t write(uint8_t slave, uint8_t *buf, uint8_t n, uint8_t end) { return fp_i2cWrite( slave, buf, n, end ); }
+    static uint8_t read(uint8_t slave, uint8_t *buf, uint8_t n, uint8_t end)  { return fp_i2cRead( slave, buf, n, end ); }
+    static void    delay10us() {}
+};
+
+/* ------------------------------------------------------------------ RUNS */
+
+struct T_result
+{
+    double      writeNs;
+    double      readNs;
+    double      measNs;
+    double      initNs;
+    uint64_t    distanceSum;
+    uint32_t    errors;
+};
+
+uint32_t loops = 10000000;
+
+uint64_t nowNs()
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+template< class Bus >
+void run(T_result *res)
+{
+    Driver< Bus > sensor;
+    uint64_t t0;
+    uint32_t i;
+    uint32_t inits = loops / 100;
+    uint32_t meas  = loops / 4;
+
+    periphReset();
+    res->errors = 0;
+
+    t0 = nowNs();
+    for (i = 0; i < inits; i++)
+    {
+        res->errors += sensor.softReset();
+        res->errors += sensor.init();
+    }
+    res->initNs = (double)(nowNs() - t0) / inits;
+
+    t0 = nowNs();
+    for (i = 0; i < loops; i++)
+    {
+        sensor.writeData( reg::HOST_TO_MCPU_MBX, (uint16_t)i );
+    }
+    res->writeNs = (double)(nowNs() - t0) / loops;
+
+    t0 = nowNs();
+    for (i = 0; i < loops; i++)
+    {
+        sensor.readData( reg::HOST_TO_MCPU_MBX );
+    }
+    res->readNs = (double)(nowNs() - t0) / loops;
+
+    periph.count = 0;
+    res->distanceSum = 0;
+    t0 = nowNs();
+    for (i = 0; i < meas; i++)
+    {
+        res->errors += sensor.takeSingleMeasurement();
+        res->distanceSum += sensor.getDistance();
+    }
+    res->measNs = (double)(nowNs() - t0) / meas;
+}
+
+void systemInit(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp( argv[ i ], "--loops" ) && i + 1 < argc)    loops = atoi( argv[ ++i ] );
+    }
+    if (loops < 100) loops = 100;
+
+    // Socket 1 unless the command line is unusually long, unknown at compile time
+    hal_i2cMap( &busObj[ argc > 64 ] );
+}
+
+void printResult(const char *name, T_result *res, const char *end)
+{
+    printf( "  \"%s\": {\"write_data_ns\": %.2f, \"read_data_ns\": %.2f, \"measurement_ns\": %.2f, "
+            "\"init_ns\": %.1f, \"errors\": %u}%s\n",
+            name, res->writeNs, res->readNs, res->measNs, res->initNs, res->errors, end );
+}
+
+int main(int argc, char **argv)
+{
+    T_result hal, tmpl;
+
+    systemInit( argc, argv );
+
+    run< HalBus >( &hal );
+    run< DirectBus >( &tmpl );
+
+    printf( "{\n" );
+    printResult( "hal", &hal, "," );
+    printResult( "template", &tmpl, "," );
+    printf( "  \"read_data_speedup\": %.2f, \"measurement_speedup\": %.2f, \"same_results\": %s\n}\n",
+            hal.readNs / tmpl.readNs, hal.measNs / tmpl.measNs,
+            hal.distanceSum == tmpl.distanceSum && hal.errors == tmpl.errors ? "true" : "false" );
+
+    return 0;
+}
@@ -0,0 +1,6 @@
+#include "Click_LightRanger_3_types.h"
+
+const T_LIGHTRANGER3_LINUX_I2C _LIGHTRANGER3_I2C_BUS = 
+{
+	"/dev/i2c-1"
+};
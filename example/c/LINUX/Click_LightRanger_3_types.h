@@ -0,0 +1,18 @@
+#ifndef _LIGHTRANGER3_T_
+#define _LIGHTRANGER3_T_
+
+#include "stdint.h"
+
+#ifndef _LIGHTRANGER3_H_
+
+#define T_LIGHTRANGER3_P const uint8_t* 
+
+#endif
+
+typedef struct
+{
+    const char  *devPath;
+
+}T_LIGHTRANGER3_LINUX_I2C;
+
+#endif
@@ -0,0 +1,284 @@
+/*
+    __HAL_LINUX.c
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+/**
+@file   __HAL_LINUX.c
+@brief    Linux user-space HAL back-end
+*/
+/**
+@defgroup   LIGHTRANGER3_HAL_LINUX
+@brief      Linux i2c-dev HAL back-end
+@{
+
+Drives the bus through /dev/i2c-N. Every register access becomes a single
+I2C_RDWR ioctl: a write that ends with END_MODE_RESTART is held back and
+sent together with the following read as one combined write + read
+transfer, and a write that ends with END_MODE_STOP is sent on its own.
+A RESTART write longer than HAL_LINUX_MAX_PENDING bytes fails.
+
+The I2C object passed to the driver init is a T_hal_i2cObj naming the bus
+device node. The file descriptor is opened on first use and kept open.
+All bus state is thread local (__HAL_THREAD__): every thread opens its own
+descriptors, so one thread per bus runs without any locking.
+Any i2c-dev endpoint works, including the kernel i2c-stub simulator
+(modprobe i2c-stub chip_addr=0x4C).
+
+With __LIGHTRANGER3_SIM__ defined the transfers go to the in-process
+RFD77402 simulator (__lightranger3_sim.c) instead, and the delays advance
+its virtual clock.
+
+*/
+/* -------------------------------------------------------------------------- */
+
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#define END_MODE_RESTART            0
+#define END_MODE_STOP               1
+
+#define HAL_LINUX_MAX_BUSES         8
+#define HAL_LINUX_MAX_PENDING       32
+
+#ifdef __LIGHTRANGER3_SIM__
+#include "__lightranger3_sim.c"
+#endif
+
+/* ---------------------------------------------------------------- DELAYS */
+
+void Delay_us(uint32_t us)
+{
+#ifdef __LIGHTRANGER3_SIM__
+    lightranger3_simSleep( us );
+#else
+    struct timespec ts;
+
+    ts.tv_sec  = us / 1000000;
+    ts.tv_nsec = (long)(us % 1000000) * 1000;
+    nanosleep( &ts, 0 );
+#endif
+}
+
+void Delay_10us()
+{
+    Delay_us( 10 );
+}
+
+void Delay_1ms()
+{
+    Delay_us( 1000 );
+}
+
+void Delay_ms(uint32_t ms)
+{
+    Delay_us( ms * 1000 );
+}
+
+void Delay_100ms()
+{
+    Delay_us( 100000 );
+}
+
+#ifdef __HAL_I2C__
+
+/* ------------------------------------------------------------------- I2C */
+
+/**
+ * @brief Linux I2C object
+ */
+typedef struct
+{
+    const char  *devPath;
+
+}T_hal_i2cObj;
+
+#ifndef __LIGHTRANGER3_SIM__
+static __HAL_THREAD__ struct
+{
+    const char  *devPath;
+    int         fd;
+
+}hal_linuxBus[ HAL_LINUX_MAX_BUSES ];
+#endif
+
+static __HAL_THREAD__ int      hal_linuxFd = -1;
+
+// Write held back until the read that completes the transfer
+static __HAL_THREAD__ uint8_t  hal_linuxPending[ HAL_LINUX_MAX_PENDING ];
+static __HAL_THREAD__ uint16_t hal_linuxPendingLen = 0;
+static __HAL_THREAD__ uint8_t  hal_linuxPendingAddr;
+static __HAL_THREAD__ uint8_t  hal_linuxPendingValid = 0;
+
+static int hal_linuxOpen(const char *devPath)
+{
+#ifdef __LIGHTRANGER3_SIM__
+    return lightranger3_simOpen( devPath );
+#else
+    uint8_t i;
+
+    for (i = 0; i < HAL_LINUX_MAX_BUSES; i++)
+    {
+        if (hal_linuxBus[ i ].devPath != 0 && strcmp( hal_linuxBus[ i ].devPath, devPath ) == 0)
+        {
+            return hal_linuxBus[ i ].fd;
+        }
+    }
+    for (i = 0; i < HAL_LINUX_MAX_BUSES; i++)
+    {
+        if (hal_linuxBus[ i ].devPath == 0)
+        {
+            hal_linuxBus[ i ].fd = open( devPath, O_RDWR );
+            if (hal_linuxBus[ i ].fd < 0)
+            {
+                return -1;
+            }
+            hal_linuxBus[ i ].devPath = devPath;
+            return hal_linuxBus[ i ].fd;
+        }
+    }
+    return -1;
+#endif
+}
+
+static int hal_linuxTransfer(struct i2c_msg *msgs, uint8_t nMsgs)
+{
+#ifdef __LIGHTRANGER3_SIM__
+    if (hal_linuxFd < 0)
+    {
+        return -1;
+    }
+    return lightranger3_simTransfer( hal_linuxFd, msgs, nMsgs );
+#else
+    struct i2c_rdwr_ioctl_data xfer;
+
+    if (hal_linuxFd < 0)
+    {
+        return -1;
+    }
+    xfer.msgs  = msgs;
+    xfer.nmsgs = nMsgs;
+
+    return (ioctl( hal_linuxFd, I2C_RDWR, &xfer ) < 0) ? -1 : 0;
+#endif
+}
+
+static void hal_i2cMap(T_HAL_P i2cObj)
+{
+    T_HAL_I2C_OBJ tmp = (T_HAL_I2C_OBJ)i2cObj;
+
+    hal_linuxFd = hal_linuxOpen( tmp->devPath );
+    hal_linuxPendingValid = 0;
+}
+
+static int hal_i2cStart()
+{
+    hal_linuxPendingValid = 0;
+    return 0;
+}
+
+static int hal_i2cWrite(uint8_t slaveAddress, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode)
+{
+    struct i2c_msg msg;
+
+    if (endMode == END_MODE_RESTART)
+    {
+        // Sent on its own with a STOP it would no longer be one transfer with the read
+        if (nBytes > HAL_LINUX_MAX_PENDING)
+        {
+            hal_linuxPendingValid = 0;
+            return -1;
+        }
+        memcpy( hal_linuxPending, pBuf, nBytes );
+        hal_linuxPendingLen   = nBytes;
+        hal_linuxPendingAddr  = slaveAddress;
+        hal_linuxPendingValid = 1;
+        return 0;
+    }
+
+    msg.addr  = slaveAddress;
+    msg.flags = 0;
+    msg.len   = nBytes;
+    msg.buf   = pBuf;
+
+    return hal_linuxTransfer( &msg, 1 );
+}
+
+static int hal_i2cRead(uint8_t slaveAddress, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode)
+{
+    struct i2c_msg msg[ 2 ];
+    uint8_t n = 0;
+
+    // A read always ends the I2C_RDWR transfer with STOP, the driver never reads on after a RESTART
+    (void)endMode;
+    if (hal_linuxPendingValid)
+    {
+        msg[ n ].addr  = hal_linuxPendingAddr;
+        msg[ n ].flags = 0;
+        msg[ n ].len   = hal_linuxPendingLen;
+        msg[ n ].buf   = hal_linuxPending;
+        n++;
+        hal_linuxPendingValid = 0;
+    }
+    msg[ n ].addr  = slaveAddress;
+    msg[ n ].flags = I2C_M_RD;
+    msg[ n ].len   = nBytes;
+    msg[ n ].buf   = pBuf;
+    n++;
+
+    return hal_linuxTransfer( msg, n );
+}
+
+#endif
+                                                                       /** @} */
+/* -------------------------------------------------------------------------- */
+/*
+  __HAL_LINUX.c
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */
@@ -0,0 +1,311 @@
+/*
+    __lightranger3_decoder.c
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+#include <string.h>
+
+#include "__lightranger3_decoder.h"
+
+/* ------------------------------------------------------------------- MACROS */
+
+// Largest sample count the frame header can carry
+#define DECODER_MAX_COUNT   8
+
+static const uint8_t CRC8_NIBBLE[ 16 ] =
+{
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+    0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+};
+
+/* -------------------------------------------- PRIVATE FUNCTION DECLARATIONS */
+
+static uint8_t _crc8(const uint8_t *data, uint8_t len);
+static uint32_t _deliver(T_lightranger3_decoder *dec, T_lightranger3_decodeFp cb, void *ctx);
+static uint32_t _resync(T_lightranger3_decoder *dec, T_lightranger3_decodeFp cb, void *ctx);
+static uint32_t _feedByte(T_lightranger3_decoder *dec, uint8_t byte, T_lightranger3_decodeFp cb, void *ctx);
+static const char* _parseU32(const char *p, uint32_t *value);
+
+/* --------------------------------------------- PRIVATE FUNCTION DEFINITIONS */
+
+static uint8_t _crc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = 0;
+    uint8_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        crc ^= data[ i ];
+        crc = (uint8_t)(crc << 4) ^ CRC8_NIBBLE[ crc >> 4 ];
+        crc = (uint8_t)(crc << 4) ^ CRC8_NIBBLE[ crc >> 4 ];
+    }
+    return crc;
+}
+
+static uint32_t _deliver(T_lightranger3_decoder *dec, T_lightranger3_decodeFp cb, void *ctx)
+{
+    T_lightranger3_sample sample;
+    const uint8_t *p;
+    uint8_t count = dec->buf[ 2 ];
+    uint8_t gap;
+    uint8_t i;
+
+    if (dec->synced)
+    {
+        gap = (uint8_t)(dec->buf[ 1 ] - dec->nextSeq);
+        dec->lostFrames  += gap;
+        dec->lostSamples += (uint32_t)gap * count;
+    }
+    dec->nextSeq = dec->buf[ 1 ] + 1;
+    dec->synced  = 1;
+    dec->frames++;
+
+    p = &dec->buf[ _LIGHTRANGER3_FRAME_HEAD ];
+    for (i = 0; i < count; i++)
+    {
+        dec->tick += (uint16_t)p[ 0 ] | ((uint16_t)p[ 1 ] << 8);
+
+        sample.timestamp       = dec->tick;
+        sample.distance        = (uint16_t)p[ 2 ] | ((uint16_t)(p[ 3 ] & 0x07) << 8);
+        sample.confidenceValue = (uint16_t)(p[ 3 ] >> 3) | ((uint16_t)(p[ 4 ] & 0x3F) << 5);
+        sample.errorCode       = p[ 4 ] >> 6;
+        if (cb != 0)
+        {
+            cb( ctx, &sample );
+        }
+        p += _LIGHTRANGER3_FRAME_RECORD;
+    }
+    dec->samples += count;
+    dec->len = 0;
+
+    return count;
+}
+
+static uint32_t _resync(T_lightranger3_decoder *dec, T_lightranger3_decodeFp cb, void *ctx)
+{
+    uint8_t  rest[ sizeof( dec->buf ) ];
+    uint8_t  n;
+    uint8_t  i;
+    uint32_t delivered = 0;
+
+    // Drop the sync byte of the rejected frame and rescan what followed it
+    n = dec->len - 1;
+    for (i = 0; i < n; i++)
+    {
+        rest[ i ] = dec->buf[ i + 1 ];
+    }
+    dec->len = 0;
+    dec->skippedBytes++;
+
+    for (i = 0; i < n; i++)
+    {
+        delivered += _feedByte( dec, rest[ i ], cb, ctx );
+    }
+    return delivered;
+}
+
+static uint32_t _feedByte(T_lightranger3_decoder *dec, uint8_t byte, T_lightranger3_decodeFp cb, void *ctx)
+{
+    uint8_t count;
+
+    if (dec->len == 0 && byte != _LIGHTRANGER3_FRAME_SYNC)
+    {
+        dec->skippedBytes++;
+        return 0;
+    }
+    dec->buf[ dec->len++ ] = byte;
+    if (dec->len < _LIGHTRANGER3_FRAME_HEAD)
+    {
+        return 0;
+    }
+
+    count = dec->buf[ 2 ];
+    if (count == 0 || count > DECODER_MAX_COUNT)
+    {
+        return _resync( dec, cb, ctx );
+    }
+    if (dec->len < _LIGHTRANGER3_FRAME_LEN( count ))
+    {
+        return 0;
+    }
+
+    if (_crc8( &dec->buf[ 1 ], dec->len - 2 ) != dec->buf[ dec->len - 1 ])
+    {
+        dec->crcErrors++;
+        return _resync( dec, cb, ctx );
+    }
+    return _deliver( dec, cb, ctx );
+}
+
+static const char* _parseU32(const char *p, uint32_t *value)
+{
+    uint64_t v = 0;
+
+    if (*p < '0' || *p > '9')
+    {
+        return 0;
+    }
+    while (*p >= '0' && *p <= '9')
+    {
+        v = v * 10 + (*p++ - '0');
+        if (v > 0xFFFFFFFFUL)
+        {
+            return 0;
+        }
+    }
+    *value = (uint32_t)v;
+    return p;
+}
+
+/* --------------------------------------------------------- PUBLIC FUNCTIONS */
+
+void lightranger3_decoderInit(T_lightranger3_decoder *dec)
+{
+    dec->len          = 0;
+    dec->nextSeq      = 0;
+    dec->synced       = 0;
+    dec->tick         = 0;
+    dec->frames       = 0;
+    dec->samples      = 0;
+    dec->crcErrors    = 0;
+    dec->lostFrames   = 0;
+    dec->lostSamples  = 0;
+    dec->skippedBytes = 0;
+}
+
+uint32_t lightranger3_decoderFeed(T_lightranger3_decoder *dec, const uint8_t *data, uint32_t len,
+                                  T_lightranger3_decodeFp cb, void *ctx)
+{
+    uint32_t delivered = 0;
+    uint32_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        delivered += _feedByte( dec, data[ i ], cb, ctx );
+    }
+    return delivered;
+}
+
+void lightranger3_histSumInit(T_lightranger3_histSum *sum)
+{
+    memset( sum, 0, sizeof( *sum ) );
+}
+
+int lightranger3_histParse(T_lightranger3_histSum *sum, const char *line)
+{
+    uint32_t field[ 4 + _LIGHTRANGER3_HIST_BUCKETS ];
+    const char *p = line;
+    uint8_t  i;
+
+    if (strncmp( p, "LR3H", 4 ) != 0)
+    {
+        return -1;
+    }
+    p += 4;
+    // Sensor, phase, fail, max and the buckets, all checked before any is added
+    for (i = 0; i < 4 + _LIGHTRANGER3_HIST_BUCKETS; i++)
+    {
+        if (*p++ != ',' || (p = _parseU32( p, &field[ i ] )) == 0)
+        {
+            return -1;
+        }
+    }
+    if ((*p != 0 && *p != '\r' && *p != '\n') || field[ 0 ] > 0xFF || field[ 1 ] >= _LIGHTRANGER3_HIST_PHASES)
+    {
+        return -1;
+    }
+
+    sum->fail[ field[ 1 ] ] += field[ 2 ];
+    if (field[ 3 ] > sum->maxUs[ field[ 1 ] ])
+    {
+        sum->maxUs[ field[ 1 ] ] = field[ 3 ];
+    }
+    for (i = 0; i < _LIGHTRANGER3_HIST_BUCKETS; i++)
+    {
+        sum->bucket[ field[ 1 ] ][ i ] += field[ 4 + i ];
+    }
+    sum->lines++;
+
+    return (int)field[ 0 ];
+}
+
+uint32_t lightranger3_histPercentile(const T_lightranger3_histSum *sum, uint8_t phase, uint16_t permille)
+{
+    uint64_t total = 0;
+    uint64_t rank;
+    uint64_t seen = 0;
+    uint32_t bound;
+    uint8_t  i;
+
+    for (i = 0; i < _LIGHTRANGER3_HIST_BUCKETS; i++)
+    {
+        total += sum->bucket[ phase ][ i ];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+    // Smallest bucket holding at least permille of the samples
+    rank = (total * permille + 999) / 1000;
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    for (i = 0; i < _LIGHTRANGER3_HIST_BUCKETS - 1; i++)
+    {
+        seen += sum->bucket[ phase ][ i ];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+    bound = i == _LIGHTRANGER3_HIST_BUCKETS - 1 ? sum->maxUs[ phase ] : _LIGHTRANGER3_HIST_LOWER( i + 1 ) - 1;
+    return bound < sum->maxUs[ phase ] ? bound : sum->maxUs[ phase ];
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+  __lightranger3_decoder.c
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */
@@ -0,0 +1,194 @@
+/*
+    __lightranger3_decoder.h
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+/**
+@file   __lightranger3_decoder.h
+@brief    LightRanger_3 Telemetry Decoder
+*/
+/**
+@defgroup   LIGHTRANGER3_DECODER
+@brief      Host side decoder of lightranger3_frameAdd output
+@{
+
+Takes the raw byte stream of a UART or any other link carrying telemetry
+frames, in chunks of any size. Every frame is checked (sync, sample count,
+CRC-8) before its samples are handed to the callback. After a bad frame the
+decoder resynchronizes on the next sync byte inside the rejected bytes, so a
+corrupted or truncated frame costs only that frame.
+
+Lost frames are found from gaps in the 8-bit frame sequence. A gap counts
+gap * count samples, count taken from the frame after the gap; more than
+255 consecutive lost frames cannot be told apart from fewer. Sample
+timestamps are rebuilt by summing the tick deltas and are shifted by the
+time of the lost samples after a gap.
+
+The same module merges the latency histogram lines of
+lightranger3_histFormat from any number of sensors into 64-bit totals.
+
+Plain C, no driver or HAL needed.
+
+*/
+/* -------------------------------------------------------------------------- */
+
+#include "stdint.h"
+
+#include "__lightranger3_driver.h"
+
+#ifndef _LIGHTRANGER3_DECODER_H_
+#define _LIGHTRANGER3_DECODER_H_
+
+/** @defgroup LIGHTRANGER3_DECODER_TYPES Types */                     /** @{ */
+
+/**
+ * @brief Decoded sample callback
+ */
+typedef void (*T_lightranger3_decodeFp)(void *ctx, T_lightranger3_sample *sample);
+
+/**
+ * @brief Decoder state and link statistics
+ */
+typedef struct
+{
+    uint8_t     buf[ _LIGHTRANGER3_FRAME_LEN( 8 ) ];
+    uint8_t     len;
+    uint8_t     nextSeq;
+    uint8_t     synced;
+    uint32_t    tick;
+
+    uint32_t    frames;         /**< Frames accepted */
+    uint32_t    samples;        /**< Samples delivered */
+    uint32_t    crcErrors;      /**< Frames rejected by CRC */
+    uint32_t    lostFrames;     /**< Frames missing from the sequence */
+    uint32_t    lostSamples;    /**< Samples in the missing frames */
+    uint32_t    skippedBytes;   /**< Bytes dropped while searching for sync */
+
+}T_lightranger3_decoder;
+
+/**
+ * @brief Merged latency histograms
+ */
+typedef struct
+{
+    uint64_t    bucket[ _LIGHTRANGER3_HIST_PHASES ][ _LIGHTRANGER3_HIST_BUCKETS ];
+    uint64_t    fail[ _LIGHTRANGER3_HIST_PHASES ];
+    uint32_t    maxUs[ _LIGHTRANGER3_HIST_PHASES ];
+    uint32_t    lines;          /**< Lines merged */
+
+}T_lightranger3_histSum;
+
+                                                                       /** @} */
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** @defgroup LIGHTRANGER3_DECODER_FUNC Decoder Functions */          /** @{ */
+
+/**
+ * @brief Initializes decoder and clears statistics
+ */
+void lightranger3_decoderInit(T_lightranger3_decoder *dec);
+
+/**
+ * @brief Feeds received bytes
+ *
+ * @param[in] dec    Decoder
+ * @param[in] data   Received bytes
+ * @param[in] len    Number of bytes
+ * @param[in] cb     Called once per decoded sample, in stream order
+ * @param[in] ctx    Passed to cb
+ *
+ * @retval number of samples delivered by this call
+ *
+ * The timestamp field of the samples carries the rebuilt tick.
+ */
+uint32_t lightranger3_decoderFeed(T_lightranger3_decoder *dec, const uint8_t *data, uint32_t len,
+                                  T_lightranger3_decodeFp cb, void *ctx);
+
+/**
+ * @brief Clears merged histograms
+ */
+void lightranger3_histSumInit(T_lightranger3_histSum *sum);
+
+/**
+ * @brief Adds one lightranger3_histFormat line
+ *
+ * @param[in] sum    Totals the line is added to
+ * @param[in] line   Text line, a trailing line end is ignored
+ *
+ * @retval sensor tag of the line, -1 if it is not a well formed histogram
+ *         line; nothing is added then
+ *
+ * Lines of several sensors added to one sum merge them. Parse per sensor
+ * into separate sums to keep them apart.
+ */
+int lightranger3_histParse(T_lightranger3_histSum *sum, const char *line);
+
+/**
+ * @brief Latency percentile of a phase
+ *
+ * @param[in] sum        Totals
+ * @param[in] phase      _LIGHTRANGER3_HIST_COMMAND, _READY or _READOUT
+ * @param[in] permille   500 for the median, 990 for p99, 1000 for the maximum
+ *
+ * @retval upper bound of the bucket holding the percentile, at most the
+ *         largest latency seen, in us; 0 without samples
+ *
+ * The bound is at most 1/2^_LIGHTRANGER3_HIST_SUB_BITS above the true
+ * percentile, exact below 2^_LIGHTRANGER3_HIST_SUB_BITS us.
+ */
+uint32_t lightranger3_histPercentile(const T_lightranger3_histSum *sum, uint8_t phase, uint16_t permille);
+
+                                                                       /** @} */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif
+                                                                       /** @} */
+/* -------------------------------------------------------------------------- */
+/*
+  __lightranger3_decoder.h
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */
@@ -44,286 +44,2153 @@ const uint8_t _LIGHTRANGER3_OFF_MODE          = 0x91;
 const uint8_t _LIGHTRANGER3_ON_MODE           = 0x92;
 const uint8_t _LIGHTRANGER3_MEASUREMENT_MODE  = 0x81;
 
+const uint8_t _LIGHTRANGER3_READY_POLL = 0x00;
+const uint8_t _LIGHTRANGER3_READY_INT  = 0x01;
+
+const uint8_t _LIGHTRANGER3_DEFAULT_ADDRESS = 0x4C;
+
+const uint8_t _LIGHTRANGER3_STEP_READY   = 0x00;
+const uint8_t _LIGHTRANGER3_STEP_ERROR   = 0x01;
+const uint8_t _LIGHTRANGER3_STEP_PENDING = 0x02;
+
+// CMD_CONFIG_A: [15:12] peak, [11:8] threshold; CMD_CONFIG_B: [15:12] frequency.
+// HW_FW_CONFIG is the same on purpose: the words of the original init
+// sequence are calibration for the module, not a range setting, so the
+// profiles differ in CMD_CONFIG only and a switch writes just those two.
+// Balanced holds the words of the original init sequence and is the only
+// supported profile. The EXP words only move the peak, threshold and
+// frequency fields away from them; their effect on range and rate has not
+// been checked on the part, only on the simulator's latency model.
+const T_lightranger3_profile _LIGHTRANGER3_PROFILE_EXP_FAST_SHORT =
+{
+    { 0x6100, 0x30FF }, { 0x07D0, 0x5008, 0xA041, 0x45D4 }
+};
+const T_lightranger3_profile _LIGHTRANGER3_PROFILE_BALANCED =
+{
+    { 0xE100, 0x10FF }, { 0x07D0, 0x5008, 0xA041, 0x45D4 }
+};
+const T_lightranger3_profile _LIGHTRANGER3_PROFILE_EXP_LONG_RANGE =
+{
+    { 0xF200, 0x00FF }, { 0x07D0, 0x5008, 0xA041, 0x45D4 }
+};
+
 static const uint8_t LIGHTRANGER3_ERROR = 0x01;
 static const uint8_t LIGHTRANGER3_OK    = 0x00;
-static const uint8_t DISTANCE_IS_GOOD   = 0x7FFF;
+// Any of RESULT [14:0] set, an all zero result was never written
+static const uint16_t DISTANCE_IS_GOOD  = 0x7FFF;
+
+// I2C_INIT_CFG: [15:9] slave address, [7:0] interface setup
+static const uint16_t I2C_INIT_CFG_SETUP = 0x0065;
+
+// CMD value of the software reset
+static const uint8_t CMD_SW_RESET       = 0x40;
+// CMD_CONFIG_A other than its reset default of 0, the balanced profile's
+static const uint16_t RESET_MARK        = 0xE100;
+
+// Largest register block written in one transaction, a macro as it sizes the buffer
+#define MAX_BLOCK_REGS  8
+
+// Default transition budgets in us
+static const uint32_t TIMEOUT_MODE_US   = 10000;
+static const uint32_t TIMEOUT_MEAS_US   = 100000;
+static const uint32_t TIMEOUT_RESET_US  = 100000;
+// Status read backoff in 10 us steps, doubled after every miss
+static const uint8_t BACKOFF_MIN        = 1;
+static const uint8_t BACKOFF_MAX        = 32;
+
+// Duty cycle wake-up margin, on top of 1/8 of the wake-up latency
+static const uint32_t DUTY_GUARD_US     = 20;
+// Calibration measurements tried before the duty cycle init gives up
+static const uint8_t DUTY_CAL_TRIES     = 3;
+
+// Transition states
+static const uint8_t STATE_IDLE         = 0x00;
+static const uint8_t STATE_WAIT         = 0x01;
+static const uint8_t STATE_READOUT      = 0x02;
+
+// CRC-8 polynomial 0x07 remainders of one nibble, two lookups per byte
+static const uint8_t CRC8_NIBBLE[ 16 ] =
+{
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+    0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+};
+
+// Field checks, a failing one declares an array of negative size
+#define FIELD_FITS(f)           typedef char f##_FITS[ (f##_WIDTH >= 1 && f##_SHIFT + f##_WIDTH <= 16) ? 1 : -1 ]
+#define FIELDS_DISJOINT(a, b)   typedef char a##_AND##b[ (_LIGHTRANGER3_FIELD_BITS(a) & _LIGHTRANGER3_FIELD_BITS(b)) == 0 ? 1 : -1 ]
+
+FIELD_FITS( _LIGHTRANGER3_ICSR_RESULT );
+FIELD_FITS( _LIGHTRANGER3_DEV_STATUS_STATE );
+FIELD_FITS( _LIGHTRANGER3_RESULT_VALID );
+FIELD_FITS( _LIGHTRANGER3_RESULT_DISTANCE );
+FIELD_FITS( _LIGHTRANGER3_RESULT_ERROR );
+FIELD_FITS( _LIGHTRANGER3_RESULT_CONFIG_CONFIDENCE );
+FIELD_FITS( _LIGHTRANGER3_I2C_INIT_CFG_SETUP );
+FIELD_FITS( _LIGHTRANGER3_I2C_INIT_CFG_ADDRESS );
+FIELD_FITS( _LIGHTRANGER3_CMD_CONFIG_A_PEAK );
+FIELD_FITS( _LIGHTRANGER3_CMD_CONFIG_A_THRESHOLD );
+FIELD_FITS( _LIGHTRANGER3_CMD_CONFIG_B_FREQUENCY );
+FIELDS_DISJOINT( _LIGHTRANGER3_RESULT_VALID, _LIGHTRANGER3_RESULT_DISTANCE );
+FIELDS_DISJOINT( _LIGHTRANGER3_RESULT_VALID, _LIGHTRANGER3_RESULT_ERROR );
+FIELDS_DISJOINT( _LIGHTRANGER3_RESULT_DISTANCE, _LIGHTRANGER3_RESULT_ERROR );
+FIELDS_DISJOINT( _LIGHTRANGER3_I2C_INIT_CFG_SETUP, _LIGHTRANGER3_I2C_INIT_CFG_ADDRESS );
+FIELDS_DISJOINT( _LIGHTRANGER3_CMD_CONFIG_A_PEAK, _LIGHTRANGER3_CMD_CONFIG_A_THRESHOLD );
+
+#define RING_MASK   ( _LIGHTRANGER3_RING_SIZE - 1 )
+
+// Index published with release after the slot access, read with acquire before it.
+// Without the GCC atomics the ring relies on one core with the producer in an ISR,
+// where volatile index accesses are enough.
+#if defined( __GNUC__ ) && defined( __ATOMIC_ACQUIRE )
+#define RING_LOAD(p)        __atomic_load_n( (p), __ATOMIC_ACQUIRE )
+#define RING_STORE(p, v)    __atomic_store_n( (p), (v), __ATOMIC_RELEASE )
+#else
+#define RING_LOAD(p)        ( *(p) )
+#define RING_STORE(p, v)    ( *(p) = (v) )
+#endif
 
 
 
 /* ---------------------------------------------------------------- VARIABLES */
 
+static T_lightranger3_dev _dev;
+static T_lightranger3_tickFp _tickSource = 0;
+static uint32_t _tickPeriodUs = 1;
+
 #ifdef   __LIGHTRANGER3_DRV_I2C__
-static uint8_t _slaveAddress;
+// Per thread, so instances on different buses can run in parallel
+static __HAL_THREAD__ T_LIGHTRANGER3_P _mappedI2c = 0;
 #endif
 
-static uint16_t _confidenceValue = 0;
-static uint16_t _distance = 0;
-
 
 /* -------------------------------------------- PRIVATE FUNCTION DECLARATIONS */
 
-
+static void _selectBus(T_lightranger3_dev *dev);
+static uint8_t _isReady(T_lightranger3_dev *dev);
+static void _readResult(T_lightranger3_dev *dev);
+static uint8_t _runTransition(T_lightranger3_dev *dev, uint8_t mode);
+static uint32_t _getTick();
+static uint8_t _timeoutSlot(uint8_t mode);
+static uint32_t _elapsedUs(T_lightranger3_dev *dev);
+static uint8_t _step(T_lightranger3_dev *dev);
+static void _makeSample(T_lightranger3_dev *dev, T_lightranger3_sample *sample);
+static void _intervalAdd(T_lightranger3_interval *iv, uint32_t tick);
+static uint8_t _bitLength(uint32_t v);
+static uint8_t _histBucket(uint32_t us);
+static uint8_t _recoverBucket(uint32_t us);
+static void _histAdd(T_lightranger3_hist *hist, uint8_t phase, uint32_t us);
+static uint8_t _putU32(char *buf, uint32_t value);
+static uint16_t _i2cInitCfg(uint8_t address);
+static uint8_t _frameClose(T_lightranger3_frame *frame);
+static uint8_t _probeId(T_lightranger3_dev *dev);
+static uint8_t _readChecked(T_lightranger3_dev *dev, uint8_t reg, uint16_t *value);
+static uint8_t _readStatus(T_lightranger3_dev *dev, uint8_t *status);
+static uint8_t _waitStandby(T_lightranger3_dev *dev, uint8_t afterReset);
+static uint8_t _reset(T_lightranger3_dev *dev);
+static uint8_t _recoverTier(T_lightranger3_dev *dev, uint8_t tier);
+static uint8_t _shadowSlot(uint8_t reg);
+static void _shadowStore(T_lightranger3_dev *dev, uint8_t reg, uint16_t value);
+static uint8_t _shadowMatch(T_lightranger3_dev *dev, uint8_t reg, uint16_t *pData, uint8_t nRegs);
+static void _commandSent(T_lightranger3_dev *dev, uint8_t reg, uint8_t cmd);
+static void _writeCached(T_lightranger3_dev *dev, uint8_t reg, uint16_t value);
+static void _writeBlockCached(T_lightranger3_dev *dev, uint8_t reg, uint16_t *pData, uint8_t nRegs);
+static uint32_t _nowUs();
+static void _waitUntil(uint32_t us);
+static uint32_t _dutyGuard(uint32_t wakeUs);
+static void _dutyLearn(uint32_t *estimate, uint32_t us);
+static void _dutyAccount(T_lightranger3_duty *duty, uint8_t state);
+static uint8_t _dutyChoose(T_lightranger3_duty *duty);
+static uint8_t _dutyEnter(T_lightranger3_dev *dev, uint8_t state);
 
 /* --------------------------------------------- PRIVATE FUNCTION DEFINITIONS */
 
+static void _selectBus(T_lightranger3_dev *dev)
+{
+#ifdef   __LIGHTRANGER3_DRV_I2C__
+    if (dev->i2cObj != _mappedI2c)
+    {
+        hal_i2cMap( (T_HAL_P)dev->i2cObj );
+        _mappedI2c = dev->i2cObj;
+    }
+#endif
+}
 
+static uint8_t _isReady(T_lightranger3_dev *dev)
+{
+    uint16_t status;
 
-/* --------------------------------------------------------- PUBLIC FUNCTIONS */
+    if (dev->target == _LIGHTRANGER3_MEASUREMENT_MODE)
+    {
+        if (dev->readyMode == _LIGHTRANGER3_READY_INT)
+        {
+            // INT_PAD is active high and cleared by the result read (ICSR = 0x05)
+            return (dev->intFlag != 0 || lightranger3_devGetInterrupt(dev) != 0);
+        }
+        return (_LIGHTRANGER3_FIELD_GET(lightranger3_devReadByte(dev, _LIGHTRANGER3_REG_ICSR), _LIGHTRANGER3_ICSR_RESULT) != 0);
+    }
 
-#ifdef   __LIGHTRANGER3_DRV_SPI__
+    status = _LIGHTRANGER3_FIELD_GET(lightranger3_devReadData(dev, _LIGHTRANGER3_REG_DEV_STATUS), _LIGHTRANGER3_DEV_STATUS_STATE);
 
-void lightranger3_spiDriverInit(T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P spiObj)
-{
-    hal_spiMap( (T_HAL_P)spiObj );
-    hal_gpioMap( (T_HAL_P)gpioObj );
+    if (dev->target == _LIGHTRANGER3_STANDBY_MODE)
+    {
+        return (status == _LIGHTRANGER3_STATE_STANDBY);
+    }
+    if (dev->target == _LIGHTRANGER3_OFF_MODE)
+    {
+        return (status == _LIGHTRANGER3_STATE_OFF);
+    }
+    return (status == _LIGHTRANGER3_STATE_ON);
 }
 
-#endif
-#ifdef   __LIGHTRANGER3_DRV_I2C__
-
-void lightranger3_i2cDriverInit(T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P i2cObj, uint8_t slave)
+static void _readResult(T_lightranger3_dev *dev)
 {
-    _slaveAddress = slave;
-    hal_i2cMap( (T_HAL_P)i2cObj );
-    hal_gpioMap( (T_HAL_P)gpioObj );
-}
+    uint8_t readReg[ 4 ];
+    uint16_t readValue;
+    uint16_t confidenceRegister;
 
-#endif
-#ifdef   __LIGHTRANGER3_DRV_UART__
+    // RESULT and RESULT_CONFIG are adjacent, fetch both in one transaction
+    lightranger3_devReadBlock(dev, _LIGHTRANGER3_REG_RESULT, readReg, 4);
+    readValue          = ((uint16_t)readReg[ 1 ] << 8) | readReg[ 0 ];
+    confidenceRegister = ((uint16_t)readReg[ 3 ] << 8) | readReg[ 2 ];
 
-void lightranger3_uartDriverInit(T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P uartObj)
-{
-    hal_uartMap( (T_HAL_P)uartObj );
-    hal_gpioMap( (T_HAL_P)gpioObj );
+    if (readValue & DISTANCE_IS_GOOD)
+    {
+        dev->errorCode = _LIGHTRANGER3_FIELD_GET(readValue, _LIGHTRANGER3_RESULT_ERROR);
+        if (dev->errorCode == 0)
+        {
+            dev->distance = _LIGHTRANGER3_FIELD_GET(readValue, _LIGHTRANGER3_RESULT_DISTANCE);
+            dev->confidenceValue = _LIGHTRANGER3_FIELD_GET(confidenceRegister, _LIGHTRANGER3_RESULT_CONFIG_CONFIDENCE);
+        }
+    }
+    else
+    {
+        dev->errorCode = LIGHTRANGER3_ERROR;
+    }
 }
 
-#endif
+static uint8_t _runTransition(T_lightranger3_dev *dev, uint8_t mode)
+{
+    uint8_t res;
+    uint8_t i;
 
-/* ----------------------------------------------------------- IMPLEMENTATION */
+    // Already there, nothing to send
+    if (mode != _LIGHTRANGER3_MEASUREMENT_MODE && dev->mode == mode)
+    {
+        dev->transitionUs = 0;
+        return _LIGHTRANGER3_STEP_READY;
+    }
 
-void lightranger3_writeByte(uint8_t reg, uint8_t _data)
+    lightranger3_devStartTransition(dev, mode);
+    for (;;)
+    {
+        res = lightranger3_devPoll(dev);
+        if (res != _LIGHTRANGER3_STEP_PENDING || dev->state != STATE_WAIT)
+        {
+            return res;
+        }
+        for (i = 0; i < dev->backoff; i++)
+        {
+            Delay_10us();
+        }
+    }
+}
+
+static uint32_t _getTick()
 {
-    uint8_t writeReg[ 2 ];
-    
-    writeReg[ 0 ] = reg;
-    writeReg[ 1 ] = _data;
-    
-    hal_i2cStart();
-    hal_i2cWrite( _slaveAddress, writeReg, 2, END_MODE_STOP );
+    if (_tickSource == 0)
+    {
+        return 0;
+    }
+    return _tickSource();
 }
 
-void lightranger3_writeData(uint8_t reg, uint16_t _data)
+static uint8_t _timeoutSlot(uint8_t mode)
 {
-    uint8_t writeReg[ 3 ];
+    if (mode == _LIGHTRANGER3_STANDBY_MODE)
+    {
+        return 0;
+    }
+    if (mode == _LIGHTRANGER3_OFF_MODE)
+    {
+        return 1;
+    }
+    if (mode == _LIGHTRANGER3_ON_MODE)
+    {
+        return 2;
+    }
+    return 3;
+}
 
-    writeReg[ 0 ] = reg;
-    writeReg[ 1 ] = _data & 0x00FF; // LSB
-    writeReg[ 2 ] = (_data & 0xFF00) >> 8; // MSB
+static uint32_t _elapsedUs(T_lightranger3_dev *dev)
+{
+    if (_tickSource == 0)
+    {
+        return dev->waitUs;
+    }
+    return (_getTick() - dev->startTick) * _tickPeriodUs;
+}
 
-    hal_i2cStart();
-    hal_i2cWrite( _slaveAddress, writeReg, 3, END_MODE_STOP );
+static uint8_t _step(T_lightranger3_dev *dev)
+{
+    uint8_t res;
+
+    res = lightranger3_devPoll(dev);
+    if (res == _LIGHTRANGER3_STEP_PENDING && dev->state == STATE_READOUT)
+    {
+        // Data is ready, read it out in the same call
+        res = lightranger3_devPoll(dev);
+    }
+    return res;
 }
 
-uint8_t lightranger3_readByte(uint8_t reg)
+static uint16_t _i2cInitCfg(uint8_t address)
 {
-    uint8_t writeReg[ 1 ];
-    uint8_t readReg[ 1 ];
-    
-    writeReg[ 0 ] = reg;
-    
-    hal_i2cStart();
-    hal_i2cWrite( _slaveAddress, writeReg, 1, END_MODE_RESTART );
-    hal_i2cRead( _slaveAddress, readReg, 1, END_MODE_STOP );
-    
-    return readReg[ 0 ];
+    if (address == _LIGHTRANGER3_DEFAULT_ADDRESS)
+    {
+        return I2C_INIT_CFG_SETUP;
+    }
+    return _LIGHTRANGER3_FIELD_PUT(_LIGHTRANGER3_I2C_INIT_CFG_ADDRESS, address) | I2C_INIT_CFG_SETUP;
 }
 
-uint16_t lightranger3_readData(uint8_t reg)
+static uint8_t _probeId(T_lightranger3_dev *dev)
 {
     uint8_t writeReg[ 1 ];
     uint8_t readReg[ 2 ];
-    uint16_t value;
-    
-    writeReg[ 0 ] = reg;
-
-    hal_i2cStart();
-    hal_i2cWrite( _slaveAddress, writeReg, 1, END_MODE_RESTART );
-    hal_i2cRead( _slaveAddress, readReg, 2, END_MODE_STOP );
+    uint16_t deviceId;
 
-    value = readReg[ 1 ];
-    value = value << 8;
-    value = value | readReg[ 0 ];
-    
-    return value;
-}
+    // Unlike devReadData, a NACK must not be read as data here
+    writeReg[ 0 ] = _LIGHTRANGER3_REG_DEVICE_ID;
+    readReg[ 0 ]  = 0;
+    readReg[ 1 ]  = 0;
 
-uint8_t lightranger3_init()
-{
-    uint8_t settings;
-    
-    if (lightranger3_getDeviceID() != 0xAD02 && lightranger3_getDeviceID() != 0xAD01)
+    _selectBus( dev );
+    if (hal_i2cStart() != 0)
     {
         return LIGHTRANGER3_ERROR;
     }
-    if (lightranger3_setStandbyMode() == 1)
-    { 
+    if (hal_i2cWrite( dev->slaveAddress, writeReg, 1, END_MODE_RESTART ) != 0)
+    {
         return LIGHTRANGER3_ERROR;
     }
-    
-    lightranger3_writeData(_LIGHTRANGER3_REG_ICSR, 0x05);
-    lightranger3_writeData(_LIGHTRANGER3_REG_IER, 0x01);
+    if (hal_i2cRead( dev->slaveAddress, readReg, 2, END_MODE_STOP ) != 0)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    deviceId = ((uint16_t)readReg[ 1 ] << 8) | readReg[ 0 ];
+    if (deviceId != 0xAD02 && deviceId != 0xAD01)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    dev->deviceId = deviceId;
+
+    return LIGHTRANGER3_OK;
+}
+
+static uint8_t _readChecked(T_lightranger3_dev *dev, uint8_t reg, uint16_t *value)
+{
+    uint8_t writeReg[ 1 ];
+    uint8_t readReg[ 2 ];
 
-    lightranger3_writeData(_LIGHTRANGER3_REG_I2C_INIT_CFG, 0x65);
-    lightranger3_writeData(_LIGHTRANGER3_REG_PMU_CONFIG, 0x0500);
+    // NACKed while the sensor reboots, an untouched buffer would read as data
+    writeReg[ 0 ] = reg;
 
-    if (lightranger3_setOffMode() == 1)
+    _selectBus( dev );
+    if (hal_i2cStart() != 0)
     {
         return LIGHTRANGER3_ERROR;
     }
-    
-    lightranger3_writeData(_LIGHTRANGER3_REG_PMU_CONFIG, 0x0600);
-
-    if (lightranger3_setOnMode() == 1)
+    if (hal_i2cWrite( dev->slaveAddress, writeReg, 1, END_MODE_RESTART ) != 0)
     {
         return LIGHTRANGER3_ERROR;
     }
-
-    lightranger3_writeData(_LIGHTRANGER3_REG_CMD_CONFIG_A,   0xE100);
-    lightranger3_writeData(_LIGHTRANGER3_REG_CMD_CONFIG_B,   0x10FF);
-    lightranger3_writeData(_LIGHTRANGER3_REG_HW_FW_CONFIG_0, 0x07D0);
-    lightranger3_writeData(_LIGHTRANGER3_REG_HW_FW_CONFIG_1, 0x5008);
-    lightranger3_writeData(_LIGHTRANGER3_REG_HW_FW_CONFIG_2, 0xA041);
-    lightranger3_writeData(_LIGHTRANGER3_REG_HW_FW_CONFIG_3, 0x45D4);
+    if (hal_i2cRead( dev->slaveAddress, readReg, 2, END_MODE_STOP ) != 0)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    *value = ((uint16_t)readReg[ 1 ] << 8) | readReg[ 0 ];
 
     return LIGHTRANGER3_OK;
 }
 
-uint8_t lightranger3_setStandbyMode()
+static uint8_t _readStatus(T_lightranger3_dev *dev, uint8_t *status)
 {
-   uint8_t x;
+    uint16_t value;
 
-   lightranger3_writeByte(_LIGHTRANGER3_REG_CMD, _LIGHTRANGER3_STANDBY_MODE);
+    if (_readChecked(dev, _LIGHTRANGER3_REG_DEV_STATUS, &value) != 0)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    *status = _LIGHTRANGER3_FIELD_GET(value, _LIGHTRANGER3_DEV_STATUS_STATE);
 
-   for (x = 0; x < 10; x++)
-   {
-       if ( (lightranger3_readData(_LIGHTRANGER3_REG_DEV_STATUS) & 0x001F) == 0x0000)
-       {
-           return LIGHTRANGER3_OK;
-       }
-       Delay_10us();
-   }
-   return LIGHTRANGER3_ERROR;
+    return LIGHTRANGER3_OK;
 }
 
-uint8_t lightranger3_setOffMode()
+static uint8_t _waitStandby(T_lightranger3_dev *dev, uint8_t afterReset)
 {
-    uint8_t x;
-
-    lightranger3_writeByte(_LIGHTRANGER3_REG_CMD, _LIGHTRANGER3_OFF_MODE);
-    for ( x = 0 ; x < 10 ; x++)
+    uint16_t configA;
+    uint8_t  started;
+    uint8_t  status;
+    uint8_t  i;
+
+    // Right after the reset command the sensor may still be in the standby
+    // it was in before; standby only counts once the reset has shown itself
+    // as a NACK, another state or CMD_CONFIG_A back at its default of 0
+    started        = !afterReset;
+    dev->waitUs    = 0;
+    dev->backoff   = BACKOFF_MIN;
+    dev->startTick = _getTick();
+    for (;;)
     {
-        if ( (lightranger3_readData(_LIGHTRANGER3_REG_DEV_STATUS) & 0x001F) == 0x0010)
+        if (_readStatus(dev, &status) != 0 || status != _LIGHTRANGER3_STATE_STANDBY)
+        {
+            started = 1;
+        }
+        else if (started)
+        {
+            return LIGHTRANGER3_OK;
+        }
+        else if (_readChecked(dev, _LIGHTRANGER3_REG_CMD_CONFIG_A, &configA) != 0)
+        {
+            started = 1;
+        }
+        else if (configA == 0)
         {
             return LIGHTRANGER3_OK;
         }
-        Delay_10us();
+        dev->waitUs += 10 * (uint32_t)dev->backoff;
+        if (_elapsedUs(dev) >= TIMEOUT_RESET_US)
+        {
+            return LIGHTRANGER3_ERROR;
+        }
+        for (i = 0; i < dev->backoff; i++)
+        {
+            Delay_10us();
+        }
+        if (dev->backoff < BACKOFF_MAX)
+        {
+            dev->backoff <<= 1;
+        }
     }
-    return LIGHTRANGER3_ERROR;
 }
 
-
-uint8_t lightranger3_setOnMode()
+static uint8_t _reset(T_lightranger3_dev *dev)
 {
-    uint8_t x;
+    uint8_t address;
+    uint8_t slot;
+
+    address = dev->slaveAddress;
+    // A CMD_CONFIG_A of 0 must mean the reset ran, so one not known to be
+    // set gets a mark first
+    slot = _shadowSlot(_LIGHTRANGER3_REG_CMD_CONFIG_A);
+    if ((dev->shadowValid & (1 << slot)) == 0 || dev->shadow[ slot ] == 0)
+    {
+        lightranger3_devWriteData(dev, _LIGHTRANGER3_REG_CMD_CONFIG_A, RESET_MARK);
+    }
+    // Also drops the whole register cache
+    lightranger3_devWriteByte(dev, _LIGHTRANGER3_REG_CMD, CMD_SW_RESET);
 
-    lightranger3_writeByte(_LIGHTRANGER3_REG_CMD, _LIGHTRANGER3_ON_MODE);
-    for ( x = 0 ; x < 10 ; x++)
+    // The reset also clears I2C_INIT_CFG, the sensor comes back on the power up address
+    dev->slaveAddress = _LIGHTRANGER3_DEFAULT_ADDRESS;
+    if (_waitStandby(dev, 1) != 0)
     {
-        if ( (lightranger3_readData(_LIGHTRANGER3_REG_DEV_STATUS) & 0x001F) == 0x0018)
-        {
-            return LIGHTRANGER3_OK;
-        }
-        Delay_10us();
+        dev->slaveAddress = address;
+        return LIGHTRANGER3_ERROR;
     }
-    return LIGHTRANGER3_ERROR;
+    if (address != _LIGHTRANGER3_DEFAULT_ADDRESS)
+    {
+        return lightranger3_devSetAddress(dev, address);
+    }
+    return LIGHTRANGER3_OK;
 }
 
-uint8_t lightranger3_setMeasurementMode()
+static uint8_t _recoverTier(T_lightranger3_dev *dev, uint8_t tier)
 {
-    uint8_t x;
+    // Forget the mode, the sensor may not be where the driver left it
+    dev->mode = 0;
 
-    lightranger3_writeByte(_LIGHTRANGER3_REG_CMD, _LIGHTRANGER3_MEASUREMENT_MODE);
-    for ( x = 0 ; x < 10 ; x++)
+    if (tier == _LIGHTRANGER3_RECOVER_ON)
+    {
+        return lightranger3_devSetOnMode(dev);
+    }
+    if (tier == _LIGHTRANGER3_RECOVER_CYCLE)
     {
-        if ( (lightranger3_readByte(_LIGHTRANGER3_REG_ICSR) & (1 << 4)) != 0)
+        // Same order and PMU settings as devInit
+        if (lightranger3_devSetStandbyMode(dev) == 1)
         {
-            return LIGHTRANGER3_OK;
+            return LIGHTRANGER3_ERROR;
+        }
+        _writeCached(dev, _LIGHTRANGER3_REG_PMU_CONFIG, 0x0500);
+        if (lightranger3_devSetOffMode(dev) == 1)
+        {
+            return LIGHTRANGER3_ERROR;
         }
-        Delay_10us();
+        _writeCached(dev, _LIGHTRANGER3_REG_PMU_CONFIG, 0x0600);
+        return lightranger3_devSetOnMode(dev);
     }
-    return LIGHTRANGER3_ERROR;
+    if (tier == _LIGHTRANGER3_RECOVER_RESET)
+    {
+        if (_reset(dev) != 0)
+        {
+            return LIGHTRANGER3_ERROR;
+        }
+        return lightranger3_devInit(dev);
+    }
+    return LIGHTRANGER3_OK;
 }
 
+static void _makeSample(T_lightranger3_dev *dev, T_lightranger3_sample *sample)
+{
+    sample->timestamp       = dev->readyTick;
+    sample->distance        = dev->distance;
+    sample->confidenceValue = dev->confidenceValue;
+    sample->errorCode       = dev->errorCode;
+}
 
-uint8_t lightranger3_takeSingleMeasurement()
+static void _intervalAdd(T_lightranger3_interval *iv, uint32_t tick)
 {
-    uint16_t readValue;
-    uint8_t errorCode;
-    uint16_t confidenceRegister;
-    
-    if (lightranger3_setMeasurementMode() == 1)
+    uint32_t us;
+    uint32_t delta;
+
+    if (_tickSource == 0)
     {
-        return LIGHTRANGER3_ERROR;
+        return;
     }
+    if (iv->started == 0)
+    {
+        // First sample after reset only opens the first interval
+        iv->lastTick = tick;
+        iv->started  = 1;
+        return;
+    }
+    us = (tick - iv->lastTick) * _tickPeriodUs;
+    iv->lastTick = tick;
 
-    readValue = lightranger3_readData(_LIGHTRANGER3_REG_RESULT);
-
-    if (readValue & DISTANCE_IS_GOOD)
+    if (iv->count != 0)
     {
-        errorCode = (readValue >> 13) & 0x03;
-        if (errorCode == 0)
-        {
-            _distance = (readValue >> 2) & 0x07FF;
-            
-            confidenceRegister = lightranger3_readData(_LIGHTRANGER3_REG_RESULT_CONFIG);
-            _confidenceValue = (confidenceRegister >> 4) & 0x07FF;
-        }
-        return (errorCode);
+        // RFC 3550: J += (|D| - J) / 16, kept as 16 J
+        delta = us > iv->lastUs ? us - iv->lastUs : iv->lastUs - us;
+        iv->jitter16 += delta - (iv->jitter16 >> 4);
     }
-    else
+    iv->lastUs = us;
+    iv->count++;
+    if (us < iv->minUs)
     {
-        return LIGHTRANGER3_ERROR;
+        iv->minUs = us;
+    }
+    if (us > iv->maxUs)
+    {
+        iv->maxUs = us;
     }
+
+    // Halve the sum and its count together instead of overflowing
+    if (iv->sumUs + us < iv->sumUs || iv->sumUs + us >= 0x80000000UL)
+    {
+        iv->sumUs    >>= 1;
+        iv->sumCount >>= 1;
+    }
+    iv->sumUs += us;
+    iv->sumCount++;
 }
 
-uint16_t lightranger3_getDistance()
+static uint8_t _bitLength(uint32_t v)
 {
-    return _distance;
+    uint8_t b = 1;
+
+    // Five steps, no loop over the bits; 1 for 0 as well
+    if (v >= 0x10000)
+    {
+        v >>= 16;
+        b += 16;
+    }
+    if (v >= 0x100)
+    {
+        v >>= 8;
+        b += 8;
+    }
+    if (v >= 0x10)
+    {
+        v >>= 4;
+        b += 4;
+    }
+    if (v >= 0x4)
+    {
+        v >>= 2;
+        b += 2;
+    }
+    if (v >= 0x2)
+    {
+        b += 1;
+    }
+    return b;
 }
 
-uint16_t lightranger3_getConfidenceValue()
+static uint8_t _histBucket(uint32_t us)
 {
-  return _confidenceValue;
+    uint8_t b;
+
+    if (us < _LIGHTRANGER3_HIST_SUB)
+    {
+        return (uint8_t)us;
+    }
+    if (us >= ((uint32_t)1 << _LIGHTRANGER3_HIST_TOP_BITS))
+    {
+        return _LIGHTRANGER3_HIST_BUCKETS - 1;
+    }
+    b = _bitLength(us);
+    // Power of two picks the group, the bits below the leading one the sub-bucket
+    return (uint8_t)(((b - _LIGHTRANGER3_HIST_SUB_BITS) << _LIGHTRANGER3_HIST_SUB_BITS)
+                     + ((us >> (b - 1 - _LIGHTRANGER3_HIST_SUB_BITS)) & (_LIGHTRANGER3_HIST_SUB - 1)));
 }
 
-uint16_t lightranger3_getDeviceID()
+static uint8_t _recoverBucket(uint32_t us)
 {
-    return lightranger3_readData(_LIGHTRANGER3_REG_DEVICE_ID);
+    if (us == 0)
+    {
+        return 0;
+    }
+    if (us >= ((uint32_t)1 << _LIGHTRANGER3_HIST_TOP_BITS))
+    {
+        return _LIGHTRANGER3_RECOVER_BUCKETS - 1;
+    }
+    return _bitLength(us);
 }
 
-void lightranger3_softReset()
+static void _histAdd(T_lightranger3_hist *hist, uint8_t phase, uint32_t us)
 {
-    lightranger3_writeByte(_LIGHTRANGER3_REG_CMD, 0x40);
-    Delay_100ms();
+    uint16_t *count;
+
+    count = &hist->bucket[ phase ][ _histBucket(us) ];
+    if (*count != 0xFFFF)
+    {
+        (*count)++;
+    }
+    if (us > hist->maxUs[ phase ])
+    {
+        hist->maxUs[ phase ] = us;
+    }
 }
 
-uint8_t lightranger3_getInterrupt()
+static uint8_t _putU32(char *buf, uint32_t value)
 {
-    return hal_gpio_intGet();
+    char    tmp[ 10 ];
+    uint8_t n = 0;
+    uint8_t i;
+
+    do
+    {
+        tmp[ n++ ] = '0' + (char)(value % 10);
+        value /= 10;
+    } while (value != 0);
+    for (i = 0; i < n; i++)
+    {
+        buf[ i ] = tmp[ n - 1 - i ];
+    }
+    return n;
 }
 
+static uint8_t _frameClose(T_lightranger3_frame *frame)
+{
+    uint8_t crc = 0;
+    uint8_t i;
+
+    frame->buf[ 2 ] = frame->count;
+    for (i = 1; i < frame->len; i++)
+    {
+        crc ^= frame->buf[ i ];
+        crc = (crc << 4) ^ CRC8_NIBBLE[ crc >> 4 ];
+        crc = (crc << 4) ^ CRC8_NIBBLE[ crc >> 4 ];
+    }
+    frame->buf[ frame->len++ ] = crc;
+    frame->count = 0;
+
+    return frame->len;
+}
 
+static uint8_t _shadowSlot(uint8_t reg)
+{
+    reg &= 0xFE;
 
+    if (reg == _LIGHTRANGER3_REG_ICSR || reg == _LIGHTRANGER3_REG_IER)
+    {
+        return reg >> 1;
+    }
+    if (reg == _LIGHTRANGER3_REG_CMD_CONFIG_A || reg == _LIGHTRANGER3_REG_CMD_CONFIG_B)
+    {
+        return 2 + ((reg - _LIGHTRANGER3_REG_CMD_CONFIG_A) >> 1);
+    }
+    if (reg == _LIGHTRANGER3_REG_PMU_CONFIG)
+    {
+        return 4;
+    }
+    if (reg == _LIGHTRANGER3_REG_I2C_INIT_CFG)
+    {
+        return 5;
+    }
+    if (reg >= _LIGHTRANGER3_REG_HW_FW_CONFIG_0 && reg <= _LIGHTRANGER3_REG_HW_FW_CONFIG_3)
+    {
+        return 6 + ((reg - _LIGHTRANGER3_REG_HW_FW_CONFIG_0) >> 1);
+    }
+    return 0xFF;
+}
+
+static void _shadowStore(T_lightranger3_dev *dev, uint8_t reg, uint16_t value)
+{
+    uint8_t slot;
+
+    slot = _shadowSlot(reg);
+    if (slot != 0xFF)
+    {
+        dev->shadow[ slot ] = value;
+        dev->shadowValid |= (1 << slot);
+    }
+}
+
+static uint8_t _shadowMatch(T_lightranger3_dev *dev, uint8_t reg, uint16_t *pData, uint8_t nRegs)
+{
+    uint8_t slot;
+    uint8_t i;
+
+    for (i = 0; i < nRegs; i++)
+    {
+        slot = _shadowSlot(reg + 2 * i);
+        if (slot == 0xFF || (dev->shadowValid & (1 << slot)) == 0 || dev->shadow[ slot ] != pData[ i ])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void _commandSent(T_lightranger3_dev *dev, uint8_t reg, uint8_t cmd)
+{
+    if (reg != _LIGHTRANGER3_REG_CMD)
+    {
+        return;
+    }
+    // Any command moves the sensor away from the cached mode, a reset also
+    // brings every register back to its default
+    if (cmd == CMD_SW_RESET)
+    {
+        lightranger3_devInvalidateCache(dev);
+    }
+    else
+    {
+        dev->mode = 0;
+    }
+}
+
+static void _writeCached(T_lightranger3_dev *dev, uint8_t reg, uint16_t value)
+{
+    if (_shadowMatch(dev, reg, &value, 1) == 0)
+    {
+        lightranger3_devWriteData(dev, reg, value);
+    }
+}
+
+static void _writeBlockCached(T_lightranger3_dev *dev, uint8_t reg, uint16_t *pData, uint8_t nRegs)
+{
+    // Trim registers the sensor already holds from both ends, the
+    // remaining span goes out as one block
+    while (nRegs != 0 && _shadowMatch(dev, reg, pData, 1))
+    {
+        reg += 2;
+        pData++;
+        nRegs--;
+    }
+    while (nRegs != 0 && _shadowMatch(dev, reg + 2 * (nRegs - 1), &pData[ nRegs - 1 ], 1))
+    {
+        nRegs--;
+    }
+    if (nRegs != 0)
+    {
+        lightranger3_devWriteBlock(dev, reg, pData, nRegs);
+    }
+}
+
+static uint32_t _nowUs()
+{
+    // Wraps with the tick, differences stay right
+    return _getTick() * _tickPeriodUs;
+}
+
+static void _waitUntil(uint32_t us)
+{
+    int32_t left;
+
+    left = (int32_t)(us - _nowUs());
+    while (left > 0)
+    {
+        if (left >= 1000)
+        {
+            Delay_1ms();
+        }
+        else
+        {
+            Delay_10us();
+        }
+        left = (int32_t)(us - _nowUs());
+    }
+}
+
+static uint32_t _dutyGuard(uint32_t wakeUs)
+{
+    return (wakeUs >> 3) + DUTY_GUARD_US;
+}
+
+static void _dutyLearn(uint32_t *estimate, uint32_t us)
+{
+    // Follow slowdowns at once, speedups slowly
+    if (us >= *estimate)
+    {
+        *estimate = us;
+    }
+    else
+    {
+        *estimate -= (*estimate - us) >> 3;
+    }
+}
+
+static void _dutyAccount(T_lightranger3_duty *duty, uint8_t state)
+{
+    uint32_t now;
+
+    now = _nowUs();
+    duty->stateUs[ duty->state ] += now - duty->markUs;
+    duty->markUs = now;
+    duty->state  = state;
+}
+
+static uint8_t _dutyChoose(T_lightranger3_duty *duty)
+{
+    uint8_t s;
+
+    // Deepest first
+    for (s = _LIGHTRANGER3_DUTY_STANDBY; s <= _LIGHTRANGER3_DUTY_OFF; s++)
+    {
+        if (duty->enterUs[ s ] + duty->wakeUs[ s ] + _dutyGuard(duty->wakeUs[ s ]) + duty->measureUs <= duty->periodUs)
+        {
+            return s;
+        }
+    }
+    return _LIGHTRANGER3_DUTY_ON;
+}
+
+static uint8_t _dutyEnter(T_lightranger3_dev *dev, uint8_t state)
+{
+    if (state == _LIGHTRANGER3_DUTY_STANDBY)
+    {
+        return lightranger3_devSetStandbyMode(dev);
+    }
+    return lightranger3_devSetOffMode(dev);
+}
+
+/* --------------------------------------------------------- PUBLIC FUNCTIONS */
+
+#ifdef   __LIGHTRANGER3_DRV_SPI__
+
+void lightranger3_spiDriverInit(T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P spiObj)
+{
+    hal_spiMap( (T_HAL_P)spiObj );
+    hal_gpioMap( (T_HAL_P)gpioObj );
+}
+
+#endif
+#ifdef   __LIGHTRANGER3_DRV_I2C__
+
+void lightranger3_i2cDriverInit(T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P i2cObj, uint8_t slave)
+{
+    lightranger3_devI2cInit( &_dev, gpioObj, i2cObj, slave );
+    hal_gpioMap( (T_HAL_P)gpioObj );
+}
+
+void lightranger3_devI2cInit(T_lightranger3_dev *dev, T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P i2cObj, uint8_t slave)
+{
+    dev->gpioObj         = gpioObj;
+    dev->i2cObj          = i2cObj;
+    dev->slaveAddress    = slave;
+    dev->distance        = 0;
+    dev->confidenceValue = 0;
+    dev->readyMode       = _LIGHTRANGER3_READY_POLL;
+    dev->intFlag         = 0;
+    dev->readyTick       = 0;
+    dev->state           = STATE_IDLE;
+    dev->target          = 0;
+    dev->polls           = 0;
+    dev->errorCode       = LIGHTRANGER3_ERROR;
+    dev->ring            = 0;
+    dev->hist            = 0;
+    dev->transitionUs    = 0;
+    dev->timeout[ 0 ]    = TIMEOUT_MODE_US;
+    dev->timeout[ 1 ]    = TIMEOUT_MODE_US;
+    dev->timeout[ 2 ]    = TIMEOUT_MODE_US;
+    dev->timeout[ 3 ]    = TIMEOUT_MEAS_US;
+    dev->profile         = &_LIGHTRANGER3_PROFILE_BALANCED;
+
+    lightranger3_devResetIntervalStats( dev );
+
+    lightranger3_devInvalidateCache( dev );
+
+    _mappedI2c = 0;
+    _selectBus( dev );
+}
+
+#endif
+#ifdef   __LIGHTRANGER3_DRV_UART__
+
+void lightranger3_uartDriverInit(T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P uartObj)
+{
+    hal_uartMap( (T_HAL_P)uartObj );
+    hal_gpioMap( (T_HAL_P)gpioObj );
+}
+
+#endif
+
+/* ----------------------------------------------------------- IMPLEMENTATION */
+
+void lightranger3_writeByte(uint8_t reg, uint8_t _data)
+{
+    lightranger3_devWriteByte( &_dev, reg, _data );
+}
+
+void lightranger3_writeData(uint8_t reg, uint16_t _data)
+{
+    lightranger3_devWriteData( &_dev, reg, _data );
+}
+
+void lightranger3_writeBlock(uint8_t reg, uint16_t *pData, uint8_t nRegs)
+{
+    lightranger3_devWriteBlock( &_dev, reg, pData, nRegs );
+}
+
+uint8_t lightranger3_readByte(uint8_t reg)
+{
+    return lightranger3_devReadByte( &_dev, reg );
+}
+
+uint16_t lightranger3_readData(uint8_t reg)
+{
+    return lightranger3_devReadData( &_dev, reg );
+}
+
+void lightranger3_readBlock(uint8_t reg, uint8_t *pBuf, uint8_t nBytes)
+{
+    lightranger3_devReadBlock( &_dev, reg, pBuf, nBytes );
+}
+
+uint8_t lightranger3_init()
+{
+    return lightranger3_devInit( &_dev );
+}
+
+uint8_t lightranger3_setStandbyMode()
+{
+    return lightranger3_devSetStandbyMode( &_dev );
+}
+
+uint8_t lightranger3_setOffMode()
+{
+    return lightranger3_devSetOffMode( &_dev );
+}
+
+uint8_t lightranger3_setOnMode()
+{
+    return lightranger3_devSetOnMode( &_dev );
+}
+
+uint8_t lightranger3_setMeasurementMode()
+{
+    return lightranger3_devSetMeasurementMode( &_dev );
+}
+
+uint8_t lightranger3_takeSingleMeasurement()
+{
+    return lightranger3_devTakeSingleMeasurement( &_dev );
+}
+
+uint16_t lightranger3_getDistance()
+{
+    return _dev.distance;
+}
+
+uint16_t lightranger3_getConfidenceValue()
+{
+  return _dev.confidenceValue;
+}
+
+void lightranger3_getSample(T_lightranger3_sample *sample)
+{
+    lightranger3_devGetSample( &_dev, sample );
+}
+
+uint16_t lightranger3_getDeviceID()
+{
+    return lightranger3_devGetDeviceID( &_dev );
+}
+
+uint8_t lightranger3_softReset()
+{
+    return lightranger3_devSoftReset( &_dev );
+}
+
+void lightranger3_invalidateCache()
+{
+    lightranger3_devInvalidateCache( &_dev );
+}
+
+uint8_t lightranger3_setProfile(const T_lightranger3_profile *profile)
+{
+    return lightranger3_devSetProfile( &_dev, profile );
+}
+
+uint8_t lightranger3_suspend()
+{
+    return lightranger3_devSuspend( &_dev );
+}
+
+uint8_t lightranger3_resume()
+{
+    return lightranger3_devResume( &_dev );
+}
+
+uint8_t lightranger3_measureWithRecovery(T_lightranger3_recovery *rec)
+{
+    return lightranger3_devMeasureWithRecovery( &_dev, rec );
+}
+
+uint8_t lightranger3_getInterrupt()
+{
+    return hal_gpio_intGet();
+}
+
+void lightranger3_setReadyMode(uint8_t mode)
+{
+    lightranger3_devSetReadyMode( &_dev, mode );
+}
+
+void lightranger3_intHandler()
+{
+    lightranger3_devIntHandler( &_dev );
+}
+
+uint8_t lightranger3_startTransition(uint8_t mode)
+{
+    return lightranger3_devStartTransition( &_dev, mode );
+}
+
+uint8_t lightranger3_startMeasurement()
+{
+    return lightranger3_devStartMeasurement( &_dev );
+}
+
+uint8_t lightranger3_poll()
+{
+    return lightranger3_devPoll( &_dev );
+}
+
+uint8_t lightranger3_getResult()
+{
+    return lightranger3_devGetResult( &_dev );
+}
+
+void lightranger3_setTickSource(T_lightranger3_tickFp tickFp)
+{
+    _tickSource = tickFp;
+#ifdef __HAL_I2C_STATS__
+    hal_i2cStatsTick = (T_hal_tickFp)tickFp;
+#endif
+}
+
+void lightranger3_setTickPeriod(uint32_t usPerTick)
+{
+    _tickPeriodUs = usPerTick;
+}
+
+void lightranger3_setTimeout(uint8_t mode, uint32_t us)
+{
+    lightranger3_devSetTimeout( &_dev, mode, us );
+}
+
+uint32_t lightranger3_getTransitionTime()
+{
+    return lightranger3_devGetTransitionTime( &_dev );
+}
+
+void lightranger3_getIntervalStats(T_lightranger3_intervalStats *stats)
+{
+    lightranger3_devGetIntervalStats( &_dev, stats );
+}
+
+void lightranger3_resetIntervalStats()
+{
+    lightranger3_devResetIntervalStats( &_dev );
+}
+
+uint8_t lightranger3_getBusStats(uint8_t slave, T_lightranger3_busStats *stats)
+{
+#ifdef __HAL_I2C_STATS__
+    T_hal_i2cStats *st;
+    uint8_t i;
+
+    st = 0;
+    if (slave == 0)
+    {
+        st = &hal_i2cStatsTotal;
+    }
+    for (i = 0; i < hal_i2cStatsUsed && st == 0; i++)
+    {
+        if (hal_i2cStatsAddr[ i ] == slave)
+        {
+            st = &hal_i2cStatsSlot[ i ];
+        }
+    }
+    if (st == 0)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    stats->starts       = st->starts;
+    stats->writes       = st->writes;
+    stats->reads        = st->reads;
+    stats->bytesWritten = st->bytesWritten;
+    stats->bytesRead    = st->bytesRead;
+    stats->errors       = st->errors;
+    stats->ticks        = st->ticks;
+
+    return LIGHTRANGER3_OK;
+#else
+    (void)slave;
+    (void)stats;
+
+    return LIGHTRANGER3_ERROR;
+#endif
+}
+
+void lightranger3_resetBusStats()
+{
+#ifdef __HAL_I2C_STATS__
+    hal_i2cStatsReset();
+#endif
+}
+
+void lightranger3_startContinuous(T_lightranger3_ring *ring)
+{
+    lightranger3_devStartContinuous( &_dev, ring );
+}
+
+void lightranger3_stopContinuous()
+{
+    lightranger3_devStopContinuous( &_dev );
+}
+
+void lightranger3_attachHist(T_lightranger3_hist *hist)
+{
+    lightranger3_devAttachHist( &_dev, hist );
+}
+
+uint8_t lightranger3_service()
+{
+    return lightranger3_devService( &_dev );
+}
+
+void lightranger3_ringInit(T_lightranger3_ring *ring)
+{
+    ring->head      = 0;
+    ring->tail      = 0;
+    ring->overflows = 0;
+}
+
+uint8_t lightranger3_ringPush(T_lightranger3_ring *ring, T_lightranger3_sample *sample)
+{
+    uint8_t head;
+
+    head = ring->head;
+    if ((uint8_t)(head - RING_LOAD( &ring->tail )) >= _LIGHTRANGER3_RING_SIZE)
+    {
+        ring->overflows++;
+        return 1;
+    }
+    ring->buf[ head & RING_MASK ] = *sample;
+    RING_STORE( &ring->head, (uint8_t)(head + 1) );
+
+    return 0;
+}
+
+uint8_t lightranger3_ringPop(T_lightranger3_ring *ring, T_lightranger3_sample *sample)
+{
+    uint8_t tail;
+
+    tail = ring->tail;
+    if (tail == RING_LOAD( &ring->head ))
+    {
+        return 0;
+    }
+    *sample = ring->buf[ tail & RING_MASK ];
+    RING_STORE( &ring->tail, (uint8_t)(tail + 1) );
+
+    return 1;
+}
+
+uint8_t lightranger3_ringCount(T_lightranger3_ring *ring)
+{
+    return (uint8_t)(RING_LOAD( &ring->head ) - RING_LOAD( &ring->tail ));
+}
+
+void lightranger3_frameInit(T_lightranger3_frame *frame, uint8_t batch)
+{
+    if (batch == 0 || batch > _LIGHTRANGER3_FRAME_MAX)
+    {
+        batch = _LIGHTRANGER3_FRAME_MAX;
+    }
+    frame->len      = 0;
+    frame->count    = 0;
+    frame->batch    = batch;
+    frame->seq      = 0;
+    frame->lastTick = 0;
+}
+
+uint8_t lightranger3_frameAdd(T_lightranger3_frame *frame, T_lightranger3_sample *sample)
+{
+    uint8_t  *p;
+    uint32_t delta;
+
+    if (frame->count == 0)
+    {
+        frame->buf[ 0 ] = _LIGHTRANGER3_FRAME_SYNC;
+        frame->buf[ 1 ] = frame->seq++;
+        frame->len      = _LIGHTRANGER3_FRAME_HEAD;
+    }
+
+    delta = sample->timestamp - frame->lastTick;
+    if (delta > 0xFFFF)
+    {
+        delta = 0xFFFF;
+    }
+    frame->lastTick = sample->timestamp;
+
+    // Byte wide shifts only, nothing wider than 16 bits on 8-bit cores
+    p = &frame->buf[ frame->len ];
+    p[ 0 ] = (uint8_t)delta;
+    p[ 1 ] = (uint8_t)(delta >> 8);
+    p[ 2 ] = (uint8_t)sample->distance;
+    p[ 3 ] = ((uint8_t)(sample->distance >> 8) & 0x07) | ((uint8_t)sample->confidenceValue << 3);
+    p[ 4 ] = ((uint8_t)(sample->confidenceValue >> 5) & 0x3F) | ((sample->errorCode & 0x03) << 6);
+    frame->len += _LIGHTRANGER3_FRAME_RECORD;
+
+    if (++frame->count < frame->batch)
+    {
+        return 0;
+    }
+    return _frameClose( frame );
+}
+
+uint8_t lightranger3_frameFlush(T_lightranger3_frame *frame)
+{
+    if (frame->count == 0)
+    {
+        return 0;
+    }
+    return _frameClose( frame );
+}
+
+void lightranger3_histInit(T_lightranger3_hist *hist)
+{
+    uint8_t p;
+    uint8_t b;
+
+    for (p = 0; p < _LIGHTRANGER3_HIST_PHASES; p++)
+    {
+        for (b = 0; b < _LIGHTRANGER3_HIST_BUCKETS; b++)
+        {
+            hist->bucket[ p ][ b ] = 0;
+        }
+        hist->maxUs[ p ] = 0;
+        hist->fail[ p ]  = 0;
+    }
+    hist->markTick = 0;
+}
+
+void lightranger3_histMerge(T_lightranger3_hist *dst, const T_lightranger3_hist *src)
+{
+    uint32_t sum;
+    uint8_t  p;
+    uint8_t  b;
+
+    for (p = 0; p < _LIGHTRANGER3_HIST_PHASES; p++)
+    {
+        for (b = 0; b < _LIGHTRANGER3_HIST_BUCKETS; b++)
+        {
+            sum = (uint32_t)dst->bucket[ p ][ b ] + src->bucket[ p ][ b ];
+            dst->bucket[ p ][ b ] = sum > 0xFFFF ? 0xFFFF : (uint16_t)sum;
+        }
+        sum = (uint32_t)dst->fail[ p ] + src->fail[ p ];
+        dst->fail[ p ] = sum > 0xFFFF ? 0xFFFF : (uint16_t)sum;
+        if (src->maxUs[ p ] > dst->maxUs[ p ])
+        {
+            dst->maxUs[ p ] = src->maxUs[ p ];
+        }
+    }
+}
+
+uint16_t lightranger3_histFormat(const T_lightranger3_hist *hist, uint8_t phase, uint8_t sensor, char *buf)
+{
+    uint16_t len;
+    uint8_t  b;
+
+    buf[ 0 ] = 'L';
+    buf[ 1 ] = 'R';
+    buf[ 2 ] = '3';
+    buf[ 3 ] = 'H';
+    len = 4;
+    buf[ len++ ] = ',';
+    len += _putU32( buf + len, sensor );
+    buf[ len++ ] = ',';
+    len += _putU32( buf + len, phase );
+    buf[ len++ ] = ',';
+    len += _putU32( buf + len, hist->fail[ phase ] );
+    buf[ len++ ] = ',';
+    len += _putU32( buf + len, hist->maxUs[ phase ] );
+    for (b = 0; b < _LIGHTRANGER3_HIST_BUCKETS; b++)
+    {
+        buf[ len++ ] = ',';
+        len += _putU32( buf + len, hist->bucket[ phase ][ b ] );
+    }
+    buf[ len ] = 0;
+
+    return len;
+}
+
+void lightranger3_recoveryInit(T_lightranger3_recovery *rec, uint8_t maxTier)
+{
+    uint8_t t;
+    uint8_t b;
+
+    rec->maxTier = maxTier < _LIGHTRANGER3_RECOVER_TIERS ? maxTier : _LIGHTRANGER3_RECOVER_RESET;
+    for (t = 0; t < _LIGHTRANGER3_RECOVER_TIERS; t++)
+    {
+        for (b = 0; b < _LIGHTRANGER3_RECOVER_BUCKETS; b++)
+        {
+            rec->bucket[ t ][ b ] = 0;
+        }
+        rec->attempts[ t ]  = 0;
+        rec->recovered[ t ] = 0;
+        rec->maxUs[ t ]     = 0;
+    }
+    rec->failed = 0;
+}
+
+/* -------------------------------------------------- MULTI-INSTANCE FUNCTIONS */
+
+void lightranger3_devWriteByte(T_lightranger3_dev *dev, uint8_t reg, uint8_t _data)
+{
+    uint8_t writeReg[ 2 ];
+    uint8_t slot;
+    
+    writeReg[ 0 ] = reg;
+    writeReg[ 1 ] = _data;
+
+    // Half a register changed, the shadowed value is no longer known
+    slot = _shadowSlot(reg);
+    if (slot != 0xFF)
+    {
+        dev->shadowValid &= ~(1 << slot);
+    }
+    _commandSent( dev, reg, _data );
+    
+    _selectBus( dev );
+    hal_i2cStart();
+    hal_i2cWrite( dev->slaveAddress, writeReg, 2, END_MODE_STOP );
+}
+
+void lightranger3_devWriteData(T_lightranger3_dev *dev, uint8_t reg, uint16_t _data)
+{
+    uint8_t writeReg[ 3 ];
+
+    writeReg[ 0 ] = reg;
+    writeReg[ 1 ] = _data & 0x00FF; // LSB
+    writeReg[ 2 ] = (_data & 0xFF00) >> 8; // MSB
+    _shadowStore( dev, reg, _data );
+    _commandSent( dev, reg, writeReg[ 1 ] );
+
+    _selectBus( dev );
+    hal_i2cStart();
+    hal_i2cWrite( dev->slaveAddress, writeReg, 3, END_MODE_STOP );
+}
+
+void lightranger3_devWriteBlock(T_lightranger3_dev *dev, uint8_t reg, uint16_t *pData, uint8_t nRegs)
+{
+    uint8_t writeReg[ 1 + 2 * MAX_BLOCK_REGS ];
+    uint8_t burst;
+    uint8_t i;
+
+    _selectBus( dev );
+    // Longer blocks go out as consecutive bursts of MAX_BLOCK_REGS registers
+    while (nRegs != 0)
+    {
+        burst = nRegs > MAX_BLOCK_REGS ? MAX_BLOCK_REGS : nRegs;
+        writeReg[ 0 ] = reg;
+        for (i = 0; i < burst; i++)
+        {
+            writeReg[ 1 + 2 * i ] = pData[ i ] & 0x00FF; // LSB
+            writeReg[ 2 + 2 * i ] = (pData[ i ] & 0xFF00) >> 8; // MSB
+            _shadowStore( dev, reg + 2 * i, pData[ i ] );
+        }
+
+        hal_i2cStart();
+        hal_i2cWrite( dev->slaveAddress, writeReg, 1 + 2 * burst, END_MODE_STOP );
+
+        reg   += 2 * burst;
+        pData += burst;
+        nRegs -= burst;
+    }
+}
+
+uint8_t lightranger3_devReadByte(T_lightranger3_dev *dev, uint8_t reg)
+{
+    uint8_t writeReg[ 1 ];
+    uint8_t readReg[ 1 ];
+    
+    writeReg[ 0 ] = reg;
+    
+    _selectBus( dev );
+    hal_i2cStart();
+    hal_i2cWrite( dev->slaveAddress, writeReg, 1, END_MODE_RESTART );
+    hal_i2cRead( dev->slaveAddress, readReg, 1, END_MODE_STOP );
+    
+    return readReg[ 0 ];
+}
+
+uint16_t lightranger3_devReadData(T_lightranger3_dev *dev, uint8_t reg)
+{
+    uint8_t writeReg[ 1 ];
+    uint8_t readReg[ 2 ];
+    uint16_t value;
+    
+    writeReg[ 0 ] = reg;
+
+    _selectBus( dev );
+    hal_i2cStart();
+    hal_i2cWrite( dev->slaveAddress, writeReg, 1, END_MODE_RESTART );
+    hal_i2cRead( dev->slaveAddress, readReg, 2, END_MODE_STOP );
+
+    value = readReg[ 1 ];
+    value = value << 8;
+    value = value | readReg[ 0 ];
+    
+    return value;
+}
+
+void lightranger3_devReadBlock(T_lightranger3_dev *dev, uint8_t reg, uint8_t *pBuf, uint8_t nBytes)
+{
+    uint8_t writeReg[ 1 ];
+
+    writeReg[ 0 ] = reg;
+
+    _selectBus( dev );
+    hal_i2cStart();
+    hal_i2cWrite( dev->slaveAddress, writeReg, 1, END_MODE_RESTART );
+    hal_i2cRead( dev->slaveAddress, pBuf, nBytes, END_MODE_STOP );
+}
+
+uint8_t lightranger3_devInit(T_lightranger3_dev *dev)
+{
+    uint16_t block[ 2 ];
+
+    // Read every time, not the cached ID: a sensor that went away must fail here
+    if (_probeId(dev) != 0)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    if (lightranger3_devSetStandbyMode(dev) == 1)
+    { 
+        return LIGHTRANGER3_ERROR;
+    }
+    
+    // Address auto-increment first, the block writes below depend on it
+    _writeCached(dev, _LIGHTRANGER3_REG_I2C_INIT_CFG, _i2cInitCfg(dev->slaveAddress));
+
+    // ICSR and IER
+    block[ 0 ] = 0x05;
+    block[ 1 ] = 0x01;
+    _writeBlockCached(dev, _LIGHTRANGER3_REG_ICSR, block, 2);
+
+    _writeCached(dev, _LIGHTRANGER3_REG_PMU_CONFIG, 0x0500);
+
+    if (lightranger3_devSetOffMode(dev) == 1)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    
+    _writeCached(dev, _LIGHTRANGER3_REG_PMU_CONFIG, 0x0600);
+
+    if (lightranger3_devSetOnMode(dev) == 1)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+
+    _writeBlockCached(dev, _LIGHTRANGER3_REG_CMD_CONFIG_A, (uint16_t*)dev->profile->cmdConfig, 2);
+    _writeBlockCached(dev, _LIGHTRANGER3_REG_HW_FW_CONFIG_0, (uint16_t*)dev->profile->hwFwConfig, 4);
+    dev->loaded = 1;
+
+    return LIGHTRANGER3_OK;
+}
+
+uint8_t lightranger3_devSetStandbyMode(T_lightranger3_dev *dev)
+{
+    return _runTransition(dev, _LIGHTRANGER3_STANDBY_MODE);
+}
+
+uint8_t lightranger3_devSetOffMode(T_lightranger3_dev *dev)
+{
+    return _runTransition(dev, _LIGHTRANGER3_OFF_MODE);
+}
+
+uint8_t lightranger3_devSetOnMode(T_lightranger3_dev *dev)
+{
+    return _runTransition(dev, _LIGHTRANGER3_ON_MODE);
+}
+
+uint8_t lightranger3_devSetMeasurementMode(T_lightranger3_dev *dev)
+{
+    // Stops once data is ready, the result is left for the readout step
+    if (_runTransition(dev, _LIGHTRANGER3_MEASUREMENT_MODE) == _LIGHTRANGER3_STEP_ERROR)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    return LIGHTRANGER3_OK;
+}
+
+uint8_t lightranger3_devTakeSingleMeasurement(T_lightranger3_dev *dev)
+{
+    if (lightranger3_devSetMeasurementMode(dev) == 1)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    lightranger3_devPoll(dev);
+
+    return lightranger3_devGetResult(dev);
+}
+
+uint16_t lightranger3_devGetDistance(T_lightranger3_dev *dev)
+{
+    return dev->distance;
+}
+
+uint16_t lightranger3_devGetConfidenceValue(T_lightranger3_dev *dev)
+{
+    return dev->confidenceValue;
+}
+
+void lightranger3_devGetSample(T_lightranger3_dev *dev, T_lightranger3_sample *sample)
+{
+    _makeSample( dev, sample );
+}
+
+uint16_t lightranger3_devGetDeviceID(T_lightranger3_dev *dev)
+{
+    uint16_t deviceId;
+
+    // DEVICE_ID never changes, only a recognised value is kept
+    if (dev->deviceId != 0)
+    {
+        return dev->deviceId;
+    }
+    deviceId = lightranger3_devReadData(dev, _LIGHTRANGER3_REG_DEVICE_ID);
+    if (deviceId == 0xAD02 || deviceId == 0xAD01)
+    {
+        dev->deviceId = deviceId;
+    }
+    return deviceId;
+}
+
+uint8_t lightranger3_devSoftReset(T_lightranger3_dev *dev)
+{
+    // Polls DEV_STATUS instead of sleeping out the worst case boot time
+    return _reset(dev);
+}
+
+void lightranger3_devInvalidateCache(T_lightranger3_dev *dev)
+{
+    dev->deviceId    = 0;
+    dev->mode        = 0;
+    dev->shadowValid = 0;
+    dev->loaded      = 0;
+}
+
+uint8_t lightranger3_devSetProfile(T_lightranger3_dev *dev, const T_lightranger3_profile *profile)
+{
+    // Registers change under a running measurement otherwise
+    if (dev->state != STATE_IDLE)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    dev->profile = profile;
+    if (dev->loaded)
+    {
+        // Only the words that differ from the shadow reach the bus
+        _writeBlockCached(dev, _LIGHTRANGER3_REG_CMD_CONFIG_A, (uint16_t*)profile->cmdConfig, 2);
+        _writeBlockCached(dev, _LIGHTRANGER3_REG_HW_FW_CONFIG_0, (uint16_t*)profile->hwFwConfig, 4);
+    }
+    return LIGHTRANGER3_OK;
+}
+
+uint8_t lightranger3_devSuspend(T_lightranger3_dev *dev)
+{
+    if (lightranger3_devSetStandbyMode(dev) == 1)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    return LIGHTRANGER3_OK;
+}
+
+uint8_t lightranger3_devResume(T_lightranger3_dev *dev)
+{
+    uint8_t readReg[ 4 ];
+    uint16_t block[ 2 ];
+
+    if (dev->loaded)
+    {
+        // CMD_CONFIG_A/B are zero after power up, a match means nothing was lost
+        lightranger3_devReadBlock(dev, _LIGHTRANGER3_REG_CMD_CONFIG_A, readReg, 4);
+        block[ 0 ] = ((uint16_t)readReg[ 1 ] << 8) | readReg[ 0 ];
+        block[ 1 ] = ((uint16_t)readReg[ 3 ] << 8) | readReg[ 2 ];
+        if (_shadowMatch(dev, _LIGHTRANGER3_REG_CMD_CONFIG_A, block, 2) == 0)
+        {
+            lightranger3_devInvalidateCache(dev);
+        }
+    }
+    if (dev->loaded == 0)
+    {
+        return lightranger3_devInit(dev);
+    }
+    if (lightranger3_devSetOnMode(dev) == 1)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    return LIGHTRANGER3_OK;
+}
+
+uint8_t lightranger3_devMeasureWithRecovery(T_lightranger3_dev *dev, T_lightranger3_recovery *rec)
+{
+    uint32_t failUs;
+    uint32_t us;
+    uint16_t *count;
+    uint8_t  maxTier;
+    uint8_t  res;
+    uint8_t  t;
+
+    res = lightranger3_devTakeSingleMeasurement(dev);
+    if (res == 0)
+    {
+        return LIGHTRANGER3_OK;
+    }
+    failUs  = _nowUs();
+    maxTier = rec != 0 ? rec->maxTier : _LIGHTRANGER3_RECOVER_RESET;
+
+    for (t = 0; t <= maxTier; t++)
+    {
+        if (rec != 0)
+        {
+            rec->attempts[ t ]++;
+        }
+        if (_recoverTier(dev, t) != 0)
+        {
+            continue;
+        }
+        res = lightranger3_devTakeSingleMeasurement(dev);
+        if (res != 0)
+        {
+            continue;
+        }
+        if (rec != 0)
+        {
+            // Time from the failed measurement to the good one, 0 without a tick source
+            us    = _nowUs() - failUs;
+            count = &rec->bucket[ t ][ _recoverBucket(us) ];
+            if (*count != 0xFFFF)
+            {
+                (*count)++;
+            }
+            if (us > rec->maxUs[ t ])
+            {
+                rec->maxUs[ t ] = us;
+            }
+            rec->recovered[ t ]++;
+        }
+        return LIGHTRANGER3_OK;
+    }
+    if (rec != 0)
+    {
+        rec->failed++;
+    }
+    return res;
+}
+
+uint8_t lightranger3_devGetInterrupt(T_lightranger3_dev *dev)
+{
+    return ((T_HAL_GPIO_OBJ)dev->gpioObj)->gpioGet[ __INT_PIN_INPUT__ ]();
+}
+
+void lightranger3_devSetReadyMode(T_lightranger3_dev *dev, uint8_t mode)
+{
+    dev->readyMode = mode;
+}
+
+void lightranger3_devIntHandler(T_lightranger3_dev *dev)
+{
+    // First edge only, the result stays latched until it is read
+    if (dev->intFlag == 0)
+    {
+        dev->readyTick = _getTick();
+    }
+    dev->intFlag = 1;
+}
+
+uint8_t lightranger3_devStartTransition(T_lightranger3_dev *dev, uint8_t mode)
+{
+    dev->target    = mode;
+    dev->polls     = 0;
+    dev->intFlag   = 0;
+    dev->errorCode = LIGHTRANGER3_ERROR;
+    dev->state     = STATE_WAIT;
+    dev->mode      = 0;
+    dev->waitUs    = 0;
+    dev->backoff   = BACKOFF_MIN;
+    dev->startTick = _getTick();
+
+    lightranger3_devWriteByte(dev, _LIGHTRANGER3_REG_CMD, mode);
+    if (dev->hist != 0 && _tickSource != 0 && mode == _LIGHTRANGER3_MEASUREMENT_MODE)
+    {
+        dev->hist->markTick = _getTick();
+        _histAdd(dev->hist, _LIGHTRANGER3_HIST_COMMAND, (dev->hist->markTick - dev->startTick) * _tickPeriodUs);
+    }
+
+    return LIGHTRANGER3_OK;
+}
+
+uint8_t lightranger3_devStartMeasurement(T_lightranger3_dev *dev)
+{
+    return lightranger3_devStartTransition(dev, _LIGHTRANGER3_MEASUREMENT_MODE);
+}
+
+uint8_t lightranger3_devPoll(T_lightranger3_dev *dev)
+{
+    if (dev->state == STATE_WAIT)
+    {
+        dev->polls++;
+        if (_isReady(dev))
+        {
+            dev->transitionUs = _elapsedUs(dev);
+            if (dev->target == _LIGHTRANGER3_MEASUREMENT_MODE)
+            {
+                // Edge tick from the INT handler, else the tick it was seen at
+                if (dev->intFlag == 0)
+                {
+                    dev->readyTick = _getTick();
+                }
+                _intervalAdd(&dev->interval, dev->readyTick);
+                if (dev->hist != 0 && _tickSource != 0)
+                {
+                    _histAdd(dev->hist, _LIGHTRANGER3_HIST_READY, (dev->readyTick - dev->hist->markTick) * _tickPeriodUs);
+                }
+
+                // The MCPU drops back to on once the result is latched
+                dev->mode  = _LIGHTRANGER3_ON_MODE;
+                dev->state = STATE_READOUT;
+                return _LIGHTRANGER3_STEP_PENDING;
+            }
+            dev->mode  = dev->target;
+            dev->state = STATE_IDLE;
+            return _LIGHTRANGER3_STEP_READY;
+        }
+
+        // Without a tick source the caller is taken to wait the backoff
+        dev->waitUs += 10 * (uint32_t)dev->backoff;
+        if (_elapsedUs(dev) >= dev->timeout[ _timeoutSlot(dev->target) ])
+        {
+            dev->transitionUs = _elapsedUs(dev);
+            if (dev->hist != 0 && _tickSource != 0 && dev->target == _LIGHTRANGER3_MEASUREMENT_MODE)
+            {
+                _histAdd(dev->hist, _LIGHTRANGER3_HIST_READY, (_getTick() - dev->hist->markTick) * _tickPeriodUs);
+                dev->hist->fail[ _LIGHTRANGER3_HIST_READY ]++;
+            }
+            dev->state = STATE_IDLE;
+            return _LIGHTRANGER3_STEP_ERROR;
+        }
+        if (dev->backoff < BACKOFF_MAX)
+        {
+            dev->backoff <<= 1;
+        }
+        return _LIGHTRANGER3_STEP_PENDING;
+    }
+
+    if (dev->state == STATE_READOUT)
+    {
+        if (dev->hist != 0 && _tickSource != 0)
+        {
+            dev->hist->markTick = _getTick();
+            _readResult(dev);
+            _histAdd(dev->hist, _LIGHTRANGER3_HIST_READOUT, (_getTick() - dev->hist->markTick) * _tickPeriodUs);
+            dev->hist->fail[ _LIGHTRANGER3_HIST_READOUT ] += (dev->errorCode != 0);
+        }
+        else
+        {
+            _readResult(dev);
+        }
+        dev->state = STATE_IDLE;
+        return _LIGHTRANGER3_STEP_READY;
+    }
+
+    return _LIGHTRANGER3_STEP_ERROR;
+}
+
+uint8_t lightranger3_devGetResult(T_lightranger3_dev *dev)
+{
+    return dev->errorCode;
+}
+
+void lightranger3_devSetTimeout(T_lightranger3_dev *dev, uint8_t mode, uint32_t us)
+{
+    dev->timeout[ _timeoutSlot(mode) ] = us;
+}
+
+uint32_t lightranger3_devGetTransitionTime(T_lightranger3_dev *dev)
+{
+    return dev->transitionUs;
+}
+
+void lightranger3_devGetIntervalStats(T_lightranger3_dev *dev, T_lightranger3_intervalStats *stats)
+{
+    T_lightranger3_interval *iv = &dev->interval;
+
+    stats->count    = iv->count;
+    stats->meanUs   = iv->sumCount != 0 ? iv->sumUs / iv->sumCount : 0;
+    stats->minUs    = iv->count != 0 ? iv->minUs : 0;
+    stats->maxUs    = iv->maxUs;
+    stats->jitterUs = iv->jitter16 >> 4;
+}
+
+void lightranger3_devResetIntervalStats(T_lightranger3_dev *dev)
+{
+    T_lightranger3_interval *iv = &dev->interval;
+
+    iv->started  = 0;
+    iv->lastTick = 0;
+    iv->lastUs   = 0;
+    iv->sumUs    = 0;
+    iv->sumCount = 0;
+    iv->jitter16 = 0;
+    iv->count    = 0;
+    iv->minUs    = 0xFFFFFFFF;
+    iv->maxUs    = 0;
+}
+
+void lightranger3_devStartContinuous(T_lightranger3_dev *dev, T_lightranger3_ring *ring)
+{
+    dev->ring = ring;
+    lightranger3_devStartMeasurement(dev);
+}
+
+void lightranger3_devStopContinuous(T_lightranger3_dev *dev)
+{
+    dev->ring  = 0;
+    dev->state = STATE_IDLE;
+}
+
+void lightranger3_devAttachHist(T_lightranger3_dev *dev, T_lightranger3_hist *hist)
+{
+    dev->hist = hist;
+}
+
+uint8_t lightranger3_devGetBusStats(T_lightranger3_dev *dev, T_lightranger3_busStats *stats)
+{
+    return lightranger3_getBusStats(dev->slaveAddress, stats);
+}
+
+uint8_t lightranger3_devService(T_lightranger3_dev *dev)
+{
+    uint8_t res;
+    T_lightranger3_sample sample;
+
+    res = _step(dev);
+    if (res == _LIGHTRANGER3_STEP_PENDING || dev->ring == 0)
+    {
+        return res;
+    }
+
+    _makeSample(dev, &sample);
+    lightranger3_ringPush(dev->ring, &sample);
+    lightranger3_devStartMeasurement(dev);
+
+    return res;
+}
+
+void lightranger3_schedInit(T_lightranger3_sched *sched, T_lightranger3_dev **devs, uint8_t count)
+{
+    sched->devs  = devs;
+    sched->count = count;
+    sched->next  = 0;
+}
+
+void lightranger3_schedStart(T_lightranger3_sched *sched)
+{
+    uint8_t i;
+
+    for (i = 0; i < sched->count; i++)
+    {
+        lightranger3_devStartMeasurement(sched->devs[ i ]);
+    }
+    sched->next = 0;
+}
+
+uint8_t lightranger3_schedService(T_lightranger3_sched *sched, T_lightranger3_sample *sample)
+{
+    T_lightranger3_dev *dev;
+    T_lightranger3_sample tmp;
+    uint8_t idx;
+
+    if (sched->count == 0)
+    {
+        return 0xFF;
+    }
+    idx = sched->next;
+    dev = sched->devs[ idx ];
+    if (++sched->next >= sched->count)
+    {
+        sched->next = 0;
+    }
+
+    if (_step(dev) == _LIGHTRANGER3_STEP_PENDING)
+    {
+        return 0xFF;
+    }
+    // Taken before the re-trigger clears the result
+    _makeSample(dev, &tmp);
+    if (dev->ring != 0)
+    {
+        lightranger3_ringPush(dev->ring, &tmp);
+    }
+    if (sample != 0)
+    {
+        *sample = tmp;
+    }
+    lightranger3_devStartMeasurement(dev);
+
+    return idx;
+}
+
+void lightranger3_schedStop(T_lightranger3_sched *sched)
+{
+    uint8_t i;
+
+    for (i = 0; i < sched->count; i++)
+    {
+        sched->devs[ i ]->state = STATE_IDLE;
+    }
+}
+
+
+
+uint8_t lightranger3_devSetAddress(T_lightranger3_dev *dev, uint8_t address)
+{
+    // Acknowledged on the old address, takes effect from the next START
+    lightranger3_devWriteData(dev, _LIGHTRANGER3_REG_I2C_INIT_CFG, _i2cInitCfg(address));
+
+    dev->slaveAddress = address;
+    dev->deviceId     = 0;
+
+    return _probeId(dev);
+}
+
+uint8_t lightranger3_provision(T_lightranger3_dev **devs, uint8_t count, uint8_t firstAddress, T_lightranger3_enableFp enableFp)
+{
+    uint16_t lastAddress;
+    uint8_t  i;
+
+    if (count == 0 || (enableFp == 0 && count > 1))
+    {
+        return 0;
+    }
+    // Every target must be a 7 bit non-reserved address other than the power up one
+    lastAddress = (uint16_t)firstAddress + count - 1;
+    if (firstAddress < 0x08 || lastAddress > 0x77
+        || (firstAddress <= _LIGHTRANGER3_DEFAULT_ADDRESS && lastAddress >= _LIGHTRANGER3_DEFAULT_ADDRESS))
+    {
+        return 0;
+    }
+    for (i = 0; i < count && enableFp != 0; i++)
+    {
+        enableFp(i, 0);
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (enableFp != 0)
+        {
+            enableFp(i, 1);
+        }
+        devs[ i ]->slaveAddress = _LIGHTRANGER3_DEFAULT_ADDRESS;
+        lightranger3_devInvalidateCache(devs[ i ]);
+        // Acknowledged and in standby once the board has booted
+        if (_waitStandby(devs[ i ], 0) != 0 || _probeId(devs[ i ]) != 0)
+        {
+            return i;
+        }
+        if (lightranger3_devSetAddress(devs[ i ], firstAddress + i) != 0)
+        {
+            return i;
+        }
+    }
+    return count;
+}
+
+uint8_t lightranger3_enumerate(T_lightranger3_dev *table, uint8_t maxCount, T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P i2cObj, uint8_t first, uint8_t last)
+{
+    uint8_t  found = 0;
+    uint16_t address;
+
+    // 0x00 - 0x07 and 0x78 - 0x7F are reserved, 0x00 is the general call;
+    // a 16 bit counter also ends on last = 0xFF
+    if (first < 0x08)
+    {
+        first = 0x08;
+    }
+    if (last > 0x77)
+    {
+        last = 0x77;
+    }
+    for (address = first; address <= last && found < maxCount; address++)
+    {
+        lightranger3_devI2cInit(&table[ found ], gpioObj, i2cObj, (uint8_t)address);
+        if (_probeId(&table[ found ]) == 0)
+        {
+            found++;
+        }
+    }
+    return found;
+}
+
+uint8_t lightranger3_dutyInit(T_lightranger3_duty *duty, T_lightranger3_dev *dev, uint32_t periodUs)
+{
+    uint32_t t;
+    uint8_t s;
+
+    if (_tickSource == 0)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    if (dev == 0)
+    {
+        dev = &_dev;
+    }
+    duty->dev      = dev;
+    duty->periodUs = periodUs ? periodUs : 1;
+    duty->overruns = 0;
+    for (s = 0; s < _LIGHTRANGER3_DUTY_STATES; s++)
+    {
+        duty->stateUs[ s ] = 0;
+    }
+
+    if (lightranger3_devSetOnMode(dev) == 1)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    for (s = _LIGHTRANGER3_DUTY_STANDBY; s <= _LIGHTRANGER3_DUTY_OFF; s++)
+    {
+        t = _nowUs();
+        if (_dutyEnter(dev, s) == 1)
+        {
+            return LIGHTRANGER3_ERROR;
+        }
+        duty->enterUs[ s ] = _nowUs() - t;
+
+        t = _nowUs();
+        if (lightranger3_devSetOnMode(dev) == 1)
+        {
+            return LIGHTRANGER3_ERROR;
+        }
+        duty->wakeUs[ s ] = _nowUs() - t;
+    }
+    // A failed measurement takes up to its timeout, its time says nothing
+    for (s = 0; s < DUTY_CAL_TRIES; s++)
+    {
+        t = _nowUs();
+        if (lightranger3_devTakeSingleMeasurement(dev) == 0)
+        {
+            break;
+        }
+    }
+    if (s == DUTY_CAL_TRIES)
+    {
+        return LIGHTRANGER3_ERROR;
+    }
+    duty->measureUs = _nowUs() - t;
+
+    duty->sleep  = _dutyChoose(duty);
+    duty->state  = _LIGHTRANGER3_DUTY_ON;
+    duty->markUs = _nowUs();
+    duty->nextUs = duty->markUs;
+
+    return LIGHTRANGER3_OK;
+}
+
+void lightranger3_dutySetPeriod(T_lightranger3_duty *duty, uint32_t periodUs)
+{
+    duty->periodUs = periodUs ? periodUs : 1;
+}
+
+uint8_t lightranger3_dutySample(T_lightranger3_duty *duty, T_lightranger3_sample *sample)
+{
+    T_lightranger3_dev *dev = duty->dev;
+    uint32_t t;
+    uint32_t late;
+    uint8_t asleep;
+    uint8_t res;
+
+    if (duty->state != _LIGHTRANGER3_DUTY_ON)
+    {
+        asleep = duty->state;
+        _waitUntil(duty->nextUs - duty->wakeUs[ asleep ] - _dutyGuard(duty->wakeUs[ asleep ]));
+
+        _dutyAccount(duty, _LIGHTRANGER3_DUTY_ON);
+        t = _nowUs();
+        if (lightranger3_devSetOnMode(dev) == 1)
+        {
+            return LIGHTRANGER3_ERROR;
+        }
+        _dutyLearn(&duty->wakeUs[ asleep ], _nowUs() - t);
+    }
+    _waitUntil(duty->nextUs);
+
+    _dutyAccount(duty, _LIGHTRANGER3_DUTY_MEASURE);
+    t = _nowUs();
+    res = lightranger3_devTakeSingleMeasurement(dev);
+    if (sample != 0)
+    {
+        _makeSample(dev, sample);
+    }
+    _dutyLearn(&duty->measureUs, _nowUs() - t);
+    _dutyAccount(duty, _LIGHTRANGER3_DUTY_ON);
+
+    // Keep the phase, periods already missed are skipped and counted
+    duty->nextUs += duty->periodUs;
+    late = _nowUs() - duty->nextUs;
+    if ((int32_t)late >= 0)
+    {
+        duty->nextUs   += (late / duty->periodUs + 1) * duty->periodUs;
+        duty->overruns += late / duty->periodUs + 1;
+    }
+
+    duty->sleep = _dutyChoose(duty);
+    if (duty->sleep != _LIGHTRANGER3_DUTY_ON)
+    {
+        t = _nowUs();
+        if (_dutyEnter(dev, duty->sleep) == 0)
+        {
+            _dutyLearn(&duty->enterUs[ duty->sleep ], _nowUs() - t);
+            _dutyAccount(duty, duty->sleep);
+        }
+    }
+
+    return res;
+}
 
 /* -------------------------------------------------------------------------- */
 /*
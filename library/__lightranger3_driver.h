@@ -51,6 +51,17 @@
    #define   __LIGHTRANGER3_DRV_I2C__                            /**<     @macro __LIGHTRANGER3_DRV_I2C__  @brief I2C driver selector */                                          
 // #define   __LIGHTRANGER3_DRV_UART__                           /**<     @macro __LIGHTRANGER3_DRV_UART__ @brief UART driver selector */ 
 
+#ifndef   _LIGHTRANGER3_RING_SIZE
+  #define   _LIGHTRANGER3_RING_SIZE    8                          /**<     @macro _LIGHTRANGER3_RING_SIZE @brief Sample ring capacity, power of two up to 128 */
+#endif
+// The ring indexes are uint8_t and masked, not taken modulo
+#if ((_LIGHTRANGER3_RING_SIZE) & ((_LIGHTRANGER3_RING_SIZE) - 1)) || (_LIGHTRANGER3_RING_SIZE) > 128 || (_LIGHTRANGER3_RING_SIZE) < 1
+#error "_LIGHTRANGER3_RING_SIZE must be a power of two from 1 to 128"
+#endif
+#ifndef   _LIGHTRANGER3_FRAME_MAX
+  #define   _LIGHTRANGER3_FRAME_MAX    8                          /**<     @macro _LIGHTRANGER3_FRAME_MAX @brief Largest telemetry batch, 1 to 8 samples per frame */
+#endif
+
                                                                        /** @} */
 /** @defgroup LIGHTRANGER3_VAR Variables */                           /** @{ */
 
@@ -82,6 +93,375 @@ extern const uint8_t _LIGHTRANGER3_OFF_MODE;
 extern const uint8_t _LIGHTRANGER3_ON_MODE;
 extern const uint8_t _LIGHTRANGER3_MEASUREMENT_MODE;
 
+// Measurement completion detection
+extern const uint8_t _LIGHTRANGER3_READY_POLL;
+extern const uint8_t _LIGHTRANGER3_READY_INT;
+
+// Register fields, read with _LIGHTRANGER3_FIELD_GET( value, field )
+#define _LIGHTRANGER3_ICSR_RESULT_SHIFT                 4
+#define _LIGHTRANGER3_ICSR_RESULT_WIDTH                 1       /**<     @macro _LIGHTRANGER3_ICSR_RESULT @brief Result ready */
+#define _LIGHTRANGER3_DEV_STATUS_STATE_SHIFT            0
+#define _LIGHTRANGER3_DEV_STATUS_STATE_WIDTH            5       /**<     @macro _LIGHTRANGER3_DEV_STATUS_STATE @brief MCPU state */
+#define _LIGHTRANGER3_RESULT_VALID_SHIFT                0
+#define _LIGHTRANGER3_RESULT_VALID_WIDTH                1
+#define _LIGHTRANGER3_RESULT_DISTANCE_SHIFT             2
+#define _LIGHTRANGER3_RESULT_DISTANCE_WIDTH             11      /**<     @macro _LIGHTRANGER3_RESULT_DISTANCE @brief Distance in mm */
+#define _LIGHTRANGER3_RESULT_ERROR_SHIFT                13
+#define _LIGHTRANGER3_RESULT_ERROR_WIDTH                2
+#define _LIGHTRANGER3_RESULT_CONFIG_CONFIDENCE_SHIFT    4
+#define _LIGHTRANGER3_RESULT_CONFIG_CONFIDENCE_WIDTH    11
+#define _LIGHTRANGER3_I2C_INIT_CFG_SETUP_SHIFT          0
+#define _LIGHTRANGER3_I2C_INIT_CFG_SETUP_WIDTH          8
+#define _LIGHTRANGER3_I2C_INIT_CFG_ADDRESS_SHIFT        9
+#define _LIGHTRANGER3_I2C_INIT_CFG_ADDRESS_WIDTH        7
+#define _LIGHTRANGER3_CMD_CONFIG_A_PEAK_SHIFT           12
+#define _LIGHTRANGER3_CMD_CONFIG_A_PEAK_WIDTH           4       /**<     @macro _LIGHTRANGER3_CMD_CONFIG_A_PEAK @brief VCSEL peak current */
+#define _LIGHTRANGER3_CMD_CONFIG_A_THRESHOLD_SHIFT      8
+#define _LIGHTRANGER3_CMD_CONFIG_A_THRESHOLD_WIDTH      4       /**<     @macro _LIGHTRANGER3_CMD_CONFIG_A_THRESHOLD @brief VCSEL threshold */
+#define _LIGHTRANGER3_CMD_CONFIG_B_FREQUENCY_SHIFT      12
+#define _LIGHTRANGER3_CMD_CONFIG_B_FREQUENCY_WIDTH      4       /**<     @macro _LIGHTRANGER3_CMD_CONFIG_B_FREQUENCY @brief VCSEL modulation frequency */
+
+// DEV_STATUS_STATE values
+#define _LIGHTRANGER3_STATE_STANDBY     0x00
+#define _LIGHTRANGER3_STATE_OFF         0x10
+#define _LIGHTRANGER3_STATE_ON          0x18
+
+// Field access, shifts and masks are constants so these fold to plain shift and and
+#define _LIGHTRANGER3_FIELD_MASK(f)     ( 0xFFFFu >> (16 - f##_WIDTH) )
+#define _LIGHTRANGER3_FIELD_BITS(f)     ( _LIGHTRANGER3_FIELD_MASK(f) << f##_SHIFT )
+#define _LIGHTRANGER3_FIELD_GET(v, f)   ( ((uint16_t)(v) >> f##_SHIFT) & _LIGHTRANGER3_FIELD_MASK(f) )
+#define _LIGHTRANGER3_FIELD_PUT(f, x)   ( ((uint16_t)(x) & _LIGHTRANGER3_FIELD_MASK(f)) << f##_SHIFT )
+
+// Slave address the sensor answers on after power up or reset
+extern const uint8_t _LIGHTRANGER3_DEFAULT_ADDRESS;
+
+// Non-blocking step results
+extern const uint8_t _LIGHTRANGER3_STEP_READY;
+extern const uint8_t _LIGHTRANGER3_STEP_ERROR;
+extern const uint8_t _LIGHTRANGER3_STEP_PENDING;
+
+                                                                       /** @} */
+/** @defgroup LIGHTRANGER3_TYPES Types */                             /** @{ */
+
+/**
+ * @brief Tick source
+ *
+ * Returns a free running monotonic tick count, typically microseconds.
+ */
+typedef uint32_t (*T_lightranger3_tickFp)();
+
+/**
+ * @brief Enable line hook
+ *
+ * Drives the enable (power) line of board index, state 1 enables it. Used
+ * by lightranger3_provision to bring identical boards up one at a time.
+ */
+typedef void (*T_lightranger3_enableFp)(uint8_t index, uint8_t state);
+
+/**
+ * @brief I2C bus usage counters
+ *
+ * Filled only when the HAL is built with __HAL_I2C_STATS__.
+ */
+typedef struct
+{
+    uint32_t            starts;
+    uint32_t            writes;
+    uint32_t            reads;
+    uint32_t            bytesWritten;
+    uint32_t            bytesRead;
+    uint32_t            errors;
+    uint32_t            ticks;
+
+}T_lightranger3_busStats;
+
+/**
+ * @brief Measurement record
+ */
+typedef struct
+{
+    uint32_t            timestamp;      /**< Tick at which the result became ready */
+    uint16_t            distance;
+    uint16_t            confidenceValue;
+    uint8_t             errorCode;
+
+}T_lightranger3_sample;
+
+/**
+ * @brief Single producer / single consumer sample ring
+ *
+ * The producer (usually an ISR) only writes head, the consumer only writes
+ * tail, so no locking is needed. When the ring is full the new sample is
+ * dropped and counted in overflows.
+ *
+ * With GCC each side publishes its index with release and reads the other
+ * with acquire ordering, so producer and consumer may run on different
+ * cores or threads. Other compilers get plain volatile accesses, which is
+ * only safe on a single core with the producer in an ISR.
+ */
+typedef struct
+{
+    T_lightranger3_sample   buf[ _LIGHTRANGER3_RING_SIZE ];
+    volatile uint8_t        head;
+    volatile uint8_t        tail;
+    volatile uint16_t       overflows;
+
+}T_lightranger3_ring;
+
+/**
+ * @brief Telemetry frame layout
+ *
+ * [0] sync 0xA5, [1] frame sequence, [2] sample count 1 - 8, then 5 bytes per
+ * sample and a CRC-8 (polynomial 0x07, init 0) over everything after sync.
+ *
+ * Sample: [0..1] tick delta to the previous sample, little endian, saturated
+ * at 0xFFFF; [2..4] distance [10:0], confidence [21:11] and error code
+ * [23:22] packed little endian.
+ */
+#define _LIGHTRANGER3_FRAME_SYNC        0xA5
+#define _LIGHTRANGER3_FRAME_HEAD        3
+#define _LIGHTRANGER3_FRAME_RECORD      5
+#define _LIGHTRANGER3_FRAME_LEN(n)      ( _LIGHTRANGER3_FRAME_HEAD + (n) * _LIGHTRANGER3_FRAME_RECORD + 1 )
+
+/**
+ * @brief Telemetry frame encoder
+ */
+typedef struct
+{
+    uint8_t     buf[ _LIGHTRANGER3_FRAME_LEN( _LIGHTRANGER3_FRAME_MAX ) ];
+    uint8_t     len;
+    uint8_t     count;
+    uint8_t     batch;
+    uint8_t     seq;
+    uint32_t    lastTick;
+
+}T_lightranger3_frame;
+
+/**
+ * @brief Latency histogram phases and buckets
+ *
+ * Log-linear buckets: every power of two is split into 2^SUB_BITS linear
+ * sub-buckets. Latencies below 2^SUB_BITS us get a bucket each, from there
+ * a bucket is 1/2^SUB_BITS of its lower edge wide, and the last bucket
+ * counts everything from 2^18 us (262 ms) up. The upper edge of a bucket is
+ * thus at most 1/2^SUB_BITS above any latency in it.
+ *
+ * The default is 0, plain powers of two in 20 buckets, small enough for
+ * 8-bit targets. Simulator builds (__LIGHTRANGER3_SIM__) default to 3 bits,
+ * 129 buckets within 12.5 %; any build can define its own value up to 4.
+ * Host and target must use the same value, the line of
+ * lightranger3_histFormat carries one count per bucket.
+ */
+#define _LIGHTRANGER3_HIST_COMMAND      0       /**<     @macro _LIGHTRANGER3_HIST_COMMAND @brief Measurement command write */
+#define _LIGHTRANGER3_HIST_READY        1       /**<     @macro _LIGHTRANGER3_HIST_READY @brief Command written to result ready */
+#define _LIGHTRANGER3_HIST_READOUT      2       /**<     @macro _LIGHTRANGER3_HIST_READOUT @brief Result read */
+#define _LIGHTRANGER3_HIST_PHASES       3
+#ifndef _LIGHTRANGER3_HIST_SUB_BITS
+#ifdef __LIGHTRANGER3_SIM__
+#define _LIGHTRANGER3_HIST_SUB_BITS     3
+#else
+#define _LIGHTRANGER3_HIST_SUB_BITS     0
+#endif
+#endif
+#if _LIGHTRANGER3_HIST_SUB_BITS > 4
+#error "_LIGHTRANGER3_HIST_SUB_BITS above 4 needs more than 255 buckets"
+#endif
+#define _LIGHTRANGER3_HIST_SUB          ( 1 << _LIGHTRANGER3_HIST_SUB_BITS )
+#define _LIGHTRANGER3_HIST_TOP_BITS     18
+#define _LIGHTRANGER3_HIST_BUCKETS      ( _LIGHTRANGER3_HIST_SUB * (_LIGHTRANGER3_HIST_TOP_BITS + 1 - _LIGHTRANGER3_HIST_SUB_BITS) + 1 )
+// Lowest latency counted in bucket k, in us
+#define _LIGHTRANGER3_HIST_LOWER(k) \
+    ( (k) < _LIGHTRANGER3_HIST_SUB ? (uint32_t)(k) \
+      : (uint32_t)(_LIGHTRANGER3_HIST_SUB + ((k) & (_LIGHTRANGER3_HIST_SUB - 1))) << (((k) >> _LIGHTRANGER3_HIST_SUB_BITS) - 1) )
+// "LR3H," address, phase, fail, max and the buckets, with separators and the terminator
+#define _LIGHTRANGER3_HIST_LINE_MAX     ( 5 + 4 + 2 + 6 + 11 + _LIGHTRANGER3_HIST_BUCKETS * 6 + 1 )
+
+/**
+ * @brief Per-phase latency histograms
+ *
+ * 142 bytes on 8-bit cores with the default 20 buckets, 796 with
+ * _LIGHTRANGER3_HIST_SUB_BITS 3.
+ */
+typedef struct
+{
+    uint16_t    bucket[ _LIGHTRANGER3_HIST_PHASES ][ _LIGHTRANGER3_HIST_BUCKETS ];  /**< Saturate at 0xFFFF */
+    uint32_t    maxUs[ _LIGHTRANGER3_HIST_PHASES ];
+    uint16_t    fail[ _LIGHTRANGER3_HIST_PHASES ];  /**< Ready: timeouts, readout: error codes, command: unused */
+    uint32_t    markTick;
+
+}T_lightranger3_hist;
+
+// Recovery tiers, cheapest first
+#define _LIGHTRANGER3_RECOVER_RETRY     0       /**<     @macro _LIGHTRANGER3_RECOVER_RETRY @brief Measure again */
+#define _LIGHTRANGER3_RECOVER_ON        1       /**<     @macro _LIGHTRANGER3_RECOVER_ON @brief Re-enter on mode */
+#define _LIGHTRANGER3_RECOVER_CYCLE     2       /**<     @macro _LIGHTRANGER3_RECOVER_CYCLE @brief Standby, off, on */
+#define _LIGHTRANGER3_RECOVER_RESET     3       /**<     @macro _LIGHTRANGER3_RECOVER_RESET @brief Reset and init */
+#define _LIGHTRANGER3_RECOVER_TIERS     4
+// Recovery time buckets, powers of two whatever _LIGHTRANGER3_HIST_SUB_BITS:
+// bucket 0 counts 0 us, bucket k from 2^(k-1) us and the last 2^18 us and up
+#define _LIGHTRANGER3_RECOVER_BUCKETS   ( _LIGHTRANGER3_HIST_TOP_BITS + 2 )
+#define _LIGHTRANGER3_RECOVER_LOWER(k)  ( (k) == 0 ? (uint32_t)0 : (uint32_t)1 << ((k) - 1) )
+
+/**
+ * @brief Recovery counters
+ *
+ * Recovery time runs from the failed measurement to the good one, in
+ * _LIGHTRANGER3_RECOVER_BUCKETS buckets per tier. 213 bytes on 8-bit cores.
+ */
+typedef struct
+{
+    uint8_t     maxTier;                                    /**< Highest tier tried */
+    uint32_t    attempts[ _LIGHTRANGER3_RECOVER_TIERS ];    /**< Times the tier ran */
+    uint32_t    recovered[ _LIGHTRANGER3_RECOVER_TIERS ];   /**< Recoveries the tier completed */
+    uint32_t    failed;                                     /**< Recoveries no tier completed */
+    uint32_t    maxUs[ _LIGHTRANGER3_RECOVER_TIERS ];
+    uint16_t    bucket[ _LIGHTRANGER3_RECOVER_TIERS ][ _LIGHTRANGER3_RECOVER_BUCKETS ];
+
+}T_lightranger3_recovery;
+
+/**
+ * @brief Inter-sample interval statistics
+ */
+typedef struct
+{
+    uint32_t            count;          /**< Intervals seen since the last reset */
+    uint32_t            meanUs;
+    uint32_t            minUs;
+    uint32_t            maxUs;
+    uint32_t            jitterUs;       /**< Smoothed change between consecutive intervals */
+
+}T_lightranger3_intervalStats;
+
+// Interval accumulator of an instance, private to the driver
+typedef struct
+{
+    uint8_t             started;
+    uint32_t            lastTick;
+    uint32_t            lastUs;
+    uint32_t            sumUs;
+    uint32_t            sumCount;
+    uint32_t            jitter16;
+    uint32_t            count;
+    uint32_t            minUs;
+    uint32_t            maxUs;
+
+}T_lightranger3_interval;
+
+/**
+ * @brief Measurement profile
+ *
+ * Register words written by init and lightranger3_setProfile.
+ */
+typedef struct
+{
+    uint16_t    cmdConfig[ 2 ];     /**< CMD_CONFIG_A, CMD_CONFIG_B */
+    uint16_t    hwFwConfig[ 4 ];    /**< HW_FW_CONFIG_0 .. HW_FW_CONFIG_3 */
+
+}T_lightranger3_profile;
+
+// _LIGHTRANGER3_PROFILE_BALANCED is the init default and the only
+// supported profile, the words of the original init sequence. The EXP
+// profiles are experimental: other peak, threshold and frequency fields
+// meant for short range at a high rate and for long range, not verified
+// on the part.
+extern const T_lightranger3_profile _LIGHTRANGER3_PROFILE_EXP_FAST_SHORT;
+extern const T_lightranger3_profile _LIGHTRANGER3_PROFILE_BALANCED;
+extern const T_lightranger3_profile _LIGHTRANGER3_PROFILE_EXP_LONG_RANGE;
+
+// Configuration registers held in the instance shadow
+#define _LIGHTRANGER3_SHADOW_REGS  10
+
+/**
+ * @brief Sensor instance
+ *
+ * Holds the bus binding and the last result of one sensor. Declare one per
+ * sensor and pass it to the lightranger3_dev* functions; members are private
+ * to the driver.
+ */
+typedef struct
+{
+    T_LIGHTRANGER3_P    gpioObj;
+    T_LIGHTRANGER3_P    i2cObj;
+    uint8_t             slaveAddress;
+
+    uint16_t            distance;
+    uint16_t            confidenceValue;
+
+    uint8_t             readyMode;
+    volatile uint8_t    intFlag;
+    volatile uint32_t   readyTick;
+    T_lightranger3_interval interval;
+
+    uint8_t             state;
+    uint8_t             target;
+    uint16_t            polls;
+    uint8_t             errorCode;
+
+    uint32_t            timeout[ 4 ];
+    uint32_t            startTick;
+    uint32_t            waitUs;
+    uint8_t             backoff;
+    uint32_t            transitionUs;
+
+    T_lightranger3_ring *ring;
+    T_lightranger3_hist *hist;
+
+    uint16_t            deviceId;
+    uint8_t             mode;
+    uint16_t            shadow[ _LIGHTRANGER3_SHADOW_REGS ];
+    uint16_t            shadowValid;
+    uint8_t             loaded;
+
+    const T_lightranger3_profile *profile;
+
+}T_lightranger3_dev;
+
+/**
+ * @brief Measurement scheduler over several sensor instances
+ *
+ * Keeps every sensor integrating and collects results as they become
+ * ready, see lightranger3_schedService.
+ */
+typedef struct
+{
+    T_lightranger3_dev  **devs;
+    uint8_t             count;
+    uint8_t             next;
+
+}T_lightranger3_sched;
+
+// Duty cycle states, index of T_lightranger3_duty.stateUs
+#define _LIGHTRANGER3_DUTY_STANDBY      0
+#define _LIGHTRANGER3_DUTY_OFF          1
+#define _LIGHTRANGER3_DUTY_ON           2       /**<     @macro _LIGHTRANGER3_DUTY_ON @brief On, idle or changing mode */
+#define _LIGHTRANGER3_DUTY_MEASURE      3
+#define _LIGHTRANGER3_DUTY_STATES       4
+
+/**
+ * @brief Duty cycle controller
+ *
+ * Samples one sensor at a fixed period and parks it in the deepest power
+ * state it can still wake from in time, see lightranger3_dutySample.
+ * sleep, stateUs and overruns may be read, the other members are private.
+ */
+typedef struct
+{
+    T_lightranger3_dev  *dev;
+    uint32_t            periodUs;
+    uint32_t            nextUs;
+    uint32_t            markUs;
+    uint8_t             state;
+
+    uint8_t             sleep;                          /**< State used between samples */
+    uint32_t            enterUs[ 2 ];                   /**< On to standby, on to off */
+    uint32_t            wakeUs[ 2 ];                    /**< Standby to on, off to on */
+    uint32_t            measureUs;
+
+    uint32_t            stateUs[ _LIGHTRANGER3_DUTY_STATES ];  /**< Time in each state */
+    uint16_t            overruns;                       /**< Sample periods missed */
+
+}T_lightranger3_duty;
+
                                                                        /** @} */
 #ifdef __cplusplus
 extern "C"{
@@ -108,7 +488,9 @@ void lightranger3_uartDriverInit(T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P uart
  * @param[in] reg    Register in which the data will be written
  * @param[in] _data  Data which be written in the register
  *
- * Use this function when you need to written one byte into the register
+ * Use this function when you need to written one byte into the register.
+ * A write to CMD drops the cached mode, the reset command (0x40) the whole
+ * register cache.
  */
 void lightranger3_writeByte(uint8_t reg, uint8_t _data);
 
@@ -122,6 +504,19 @@ void lightranger3_writeByte(uint8_t reg, uint8_t _data);
  */
 void lightranger3_writeData(uint8_t reg, uint16_t _data);
 
+/**
+ * @brief Functions for write block of registers
+ *
+ * @param[in] reg     First register of the block
+ * @param[in] pData   Register values
+ * @param[in] nRegs   Number of 16 bit registers to write
+ *
+ * Writes consecutive registers in one bus transaction, blocks of more than 8
+ * registers in one transaction per 8. Relies on address auto-increment,
+ * which init enables in I2C_INIT_CFG before any block write.
+ */
+void lightranger3_writeBlock(uint8_t reg, uint16_t *pData, uint8_t nRegs);
+
 /**
  * @brief Functions for read one byte from register
  *
@@ -140,6 +535,18 @@ uint8_t lightranger3_readByte(uint8_t reg);
  */
 uint16_t lightranger3_readData(uint8_t reg);
 
+/**
+ * @brief Functions for read block of registers
+ *
+ * @param[in]  reg     First register of the block
+ * @param[out] pBuf    Buffer for the read bytes
+ * @param[in]  nBytes  Number of bytes to read
+ *
+ * Reads consecutive registers in one bus transaction. Registers are 16 bit
+ * little endian, so a block of n registers is 2 * n bytes.
+ */
+void lightranger3_readBlock(uint8_t reg, uint8_t *pBuf, uint8_t nBytes);
+
 /**
  * @brief Functions for initializes chip
  *
@@ -147,10 +554,11 @@ uint16_t lightranger3_readData(uint8_t reg);
            else returns a message "LIGHTRANGER3_OK" about the successfully executed function.
  *
  * Procedure for init:
+      - Read DEVICE_ID, a NACK or unknown ID fails
       - Go to standby mode
       - Check standby status
-      - Driver INT_PAD high init
       - Consfigure I2C interface
+      - Driver INT_PAD high init
       - Set Initialization
       - Go to off mode
       - Check MCPU off status
@@ -224,6 +632,18 @@ uint16_t lightranger3_getDistance();
  */
 uint16_t lightranger3_getConfidenceValue();
 
+/**
+ * @brief Functions for reads last measurement as sample record
+ *
+ * @param[out] sample   Distance, confidence, error code and ready tick
+ *
+ * The tick is taken when the result became ready: in the INT handler when
+ * lightranger3_intHandler is used, else when the driver saw the data
+ * ready bit or the INT pin, at most one status read backoff later. It does
+ * not include the readout time.
+ */
+void lightranger3_getSample(T_lightranger3_sample *sample);
+
 /**
  * @brief Functions for reads device ID
  *
@@ -233,8 +653,93 @@ uint16_t lightranger3_getDeviceID();
 
 /**
  * @brief Functions for softReset
+ *
+ * @retval 0 once the sensor is back, 1 if it is not back in standby within
+ *         100 ms or does not take its address again
+ *
+ * Also drops the register shadow, see lightranger3_invalidateCache.
+ * Standby only counts once the reset has shown itself, as a NACK, another
+ * state or CMD_CONFIG_A read back at its default of 0; a CMD_CONFIG_A not
+ * known to be set is written first. A sensor moved off the power up address
+ * is moved back to its address, so no other sensor may answer on the power
+ * up address meanwhile.
+ */
+uint8_t lightranger3_softReset();
+
+/**
+ * @brief Functions for measurement with tiered error recovery
+ *
+ * @param[in] rec   Counters and tier limit, may be 0 for all tiers without
+ *                  counting
+ *
+ * @retval 0 when a good result was read, else the error of the last attempt
+ *
+ * Takes a single measurement. On a timeout or an error code it retries
+ * the measurement, then re-enters on mode, then goes through standby, off
+ * and on, and last resets and initializes the sensor, measuring again
+ * after each tier until one succeeds. Error codes can also mean no target
+ * in range, which no tier will change; limit rec->maxTier there.
+ */
+uint8_t lightranger3_measureWithRecovery(T_lightranger3_recovery *rec);
+
+/**
+ * @brief Functions for initializes recovery counters
+ *
+ * @param[out] rec       Counters
+ * @param[in]  maxTier   Highest tier to try, _LIGHTRANGER3_RECOVER_RESET for all
+ */
+void lightranger3_recoveryInit(T_lightranger3_recovery *rec, uint8_t maxTier);
+
+/**
+ * @brief Functions for invalidate register shadow
+ *
+ * The driver keeps a write-through copy of the configuration registers,
+ * the device ID and the last confirmed power mode, and skips writes and
+ * mode changes that would not change anything. Call this whenever the
+ * sensor may have lost its state behind the driver's back, for example
+ * after a power cycle of the click.
  */
-void lightranger3_softReset();
+void lightranger3_invalidateCache();
+
+/**
+ * @brief Functions for select measurement profile
+ *
+ * @param[in] profile   _LIGHTRANGER3_PROFILE_BALANCED (default), the
+ *                      experimental _LIGHTRANGER3_PROFILE_EXP_FAST_SHORT
+ *                      or _LIGHTRANGER3_PROFILE_EXP_LONG_RANGE, or an own
+ *                      profile
+ *
+ * @retval 0 on success, 1 while a measurement is in progress
+ *
+ * On an initialized sensor only the registers that differ from the
+ * current profile are written, in a single block, and the sensor stays in
+ * on mode. Before lightranger3_init the profile is only recorded and is
+ * loaded by init. The profile is referenced, not copied, and has to
+ * outlive its use.
+ */
+uint8_t lightranger3_setProfile(const T_lightranger3_profile *profile);
+
+/**
+ * @brief Functions for suspend sensor to standby
+ *
+ * @retval 0 when the sensor is in standby, 1 if the transition failed
+ *
+ * The loaded configuration stays recorded in the driver, so
+ * lightranger3_resume can skip the init sequence.
+ */
+uint8_t lightranger3_suspend();
+
+/**
+ * @brief Functions for resume sensor after lightranger3_suspend
+ *
+ * @retval 0 when the sensor is on and ready to measure, 1 on error
+ *
+ * If the configuration recorded at init still reads back from the sensor
+ * only the on mode command is sent. When the sensor lost its registers
+ * (power cycle, brown-out) or was never initialized, the full
+ * lightranger3_init sequence is run instead.
+ */
+uint8_t lightranger3_resume();
 
 /**
  * @brief Functions for reads interrupt pin
@@ -243,11 +748,608 @@ void lightranger3_softReset();
  */
 uint8_t lightranger3_getInterrupt();
 
+/**
+ * @brief Functions for select how measurement completion is detected
+ *
+ * @param[in] mode   _LIGHTRANGER3_READY_POLL or _LIGHTRANGER3_READY_INT
+ *
+ * _LIGHTRANGER3_READY_POLL (default) reads ICSR over I2C until the data ready
+ * bit is set. _LIGHTRANGER3_READY_INT waits on the INT pin, or on
+ * lightranger3_intHandler being called, and does not touch the bus until
+ * the result is available.
+ */
+void lightranger3_setReadyMode(uint8_t mode);
+
+/**
+ * @brief Functions for signal INT pin edge
+ *
+ * Call this function from the external interrupt routine attached to the
+ * INT pin rising edge when _LIGHTRANGER3_READY_INT mode is used.
+ */
+void lightranger3_intHandler();
+
+/**
+ * @brief Functions for start mode transition without waiting
+ *
+ * @param[in] mode   _LIGHTRANGER3_STANDBY_MODE, _LIGHTRANGER3_OFF_MODE,
+ *                   _LIGHTRANGER3_ON_MODE or _LIGHTRANGER3_MEASUREMENT_MODE
+ *
+ * @retval LIGHTRANGER3_OK
+ *
+ * Writes the command and returns. Call lightranger3_poll until it stops
+ * returning _LIGHTRANGER3_STEP_PENDING.
+ */
+uint8_t lightranger3_startTransition(uint8_t mode);
+
+/**
+ * @brief Functions for start measurement without waiting
+ *
+ * Same as lightranger3_startTransition( _LIGHTRANGER3_MEASUREMENT_MODE ).
+ */
+uint8_t lightranger3_startMeasurement();
+
+/**
+ * @brief Functions for advance started transition by one step
+ *
+ * @retval _LIGHTRANGER3_STEP_PENDING while the transition is in progress,
+ *         _LIGHTRANGER3_STEP_READY when it has completed and
+ *         _LIGHTRANGER3_STEP_ERROR if it timed out or nothing was started.
+ *
+ * Never blocks and issues at most one bus transaction per call. A
+ * measurement completes after the result has been read, so the step that
+ * sees the data ready bit still returns _LIGHTRANGER3_STEP_PENDING.
+ */
+uint8_t lightranger3_poll();
+
+/**
+ * @brief Functions for reads result of the last measurement
+ *
+ * @retval error code of the last completed measurement, 0 when distance and
+ *         confidence value were updated.
+ */
+uint8_t lightranger3_getResult();
+
+/**
+ * @brief Functions for set tick source used for sample timestamps
+ *
+ * @param[in] tickFp   Free running tick function, 0 disables timestamps
+ *
+ * The same source times the transition deadlines. Without one, elapsed
+ * time is estimated from the backoff delays between status reads.
+ */
+void lightranger3_setTickSource(T_lightranger3_tickFp tickFp);
+
+/**
+ * @brief Functions for set tick period
+ *
+ * @param[in] usPerTick   Microseconds per tick of the tick source, default 1
+ */
+void lightranger3_setTickPeriod(uint32_t usPerTick);
+
+/**
+ * @brief Functions for set transition time budget
+ *
+ * @param[in] mode   _LIGHTRANGER3_STANDBY_MODE, _LIGHTRANGER3_OFF_MODE,
+ *                   _LIGHTRANGER3_ON_MODE or _LIGHTRANGER3_MEASUREMENT_MODE
+ * @param[in] us     Time the sensor is given to reach the mode
+ *
+ * Defaults are 10 ms for the power modes and 100 ms for a measurement.
+ * Status reads start 10 us apart and back off exponentially up to 320 us.
+ */
+void lightranger3_setTimeout(uint8_t mode, uint32_t us);
+
+/**
+ * @brief Functions for reads duration of the last transition
+ *
+ * @retval microseconds from the mode command to the status read that saw
+ *         the mode reached, or to the timeout
+ *
+ * A blocking mode change that was skipped because the sensor was already
+ * in the mode reports 0.
+ */
+uint32_t lightranger3_getTransitionTime();
+
+/**
+ * @brief Functions for reads inter-sample interval statistics
+ *
+ * @param[out] stats   Intervals between the ready ticks of consecutive
+ *                     measurements
+ *
+ * The mean is exact until the interval sum passes 2^31 us, from then on
+ * older intervals weigh half at every overflow. Jitter is the RFC 3550
+ * estimator, the change between consecutive intervals smoothed by 1/16.
+ * Needs a tick source, all zero without one.
+ */
+void lightranger3_getIntervalStats(T_lightranger3_intervalStats *stats);
+
+/**
+ * @brief Functions for restart interval statistics
+ *
+ * Call after a pause in sampling so the gap does not count as an interval.
+ */
+void lightranger3_resetIntervalStats();
+
+/**
+ * @brief Functions for reads I2C bus usage counters
+ *
+ * @param[in]  slave   Slave address, 0 for the totals of all addresses
+ * @param[out] stats   Counters
+ *
+ * @retval 0 on success, 1 if the HAL is built without __HAL_I2C_STATS__ or
+ *         the address has not been seen (or did not fit the address table)
+ *
+ * Start conditions carry no address and are only counted in the totals.
+ * Elapsed ticks use the source set with lightranger3_setTickSource.
+ * On Linux the counters are kept per thread, so a bus worker thread reads
+ * the counters of its own bus.
+ */
+uint8_t lightranger3_getBusStats(uint8_t slave, T_lightranger3_busStats *stats);
+
+/**
+ * @brief Functions for clear I2C bus usage counters
+ */
+void lightranger3_resetBusStats();
+
+/**
+ * @brief Functions for start continuous measurement
+ *
+ * @param[in] ring   Ring the samples are pushed into
+ *
+ * Triggers a measurement and from then on re-triggers one every time the
+ * previous completes, as long as lightranger3_service is being called.
+ */
+void lightranger3_startContinuous(T_lightranger3_ring *ring);
+
+/**
+ * @brief Functions for stop continuous measurement
+ *
+ * The measurement in progress, if any, is not pushed into the ring.
+ */
+void lightranger3_stopContinuous();
+
+/**
+ * @brief Functions for service continuous measurement
+ *
+ * @retval result of the underlying lightranger3_poll step
+ *
+ * Call it from the main loop or from the INT pin interrupt routine. On
+ * completion the sample is pushed into the ring and the next measurement is
+ * triggered.
+ */
+uint8_t lightranger3_service();
+
+/**
+ * @brief Functions for initializes sample ring
+ */
+void lightranger3_ringInit(T_lightranger3_ring *ring);
+
+/**
+ * @brief Functions for push sample into the ring
+ *
+ * @retval 0 on success, 1 if the ring was full and the sample was dropped
+ *
+ * Producer side, safe to call from an interrupt routine.
+ */
+uint8_t lightranger3_ringPush(T_lightranger3_ring *ring, T_lightranger3_sample *sample);
+
+/**
+ * @brief Functions for pop sample from the ring
+ *
+ * @retval 1 if a sample was copied to sample, 0 if the ring was empty
+ *
+ * Consumer side.
+ */
+uint8_t lightranger3_ringPop(T_lightranger3_ring *ring, T_lightranger3_sample *sample);
+
+/**
+ * @brief Functions for reads number of samples waiting in the ring
+ */
+uint8_t lightranger3_ringCount(T_lightranger3_ring *ring);
+
+/**
+ * @brief Functions for initializes telemetry frame encoder
+ *
+ * @param[out] frame   Encoder
+ * @param[in]  batch   Samples per frame, 1 to _LIGHTRANGER3_FRAME_MAX
+ */
+void lightranger3_frameInit(T_lightranger3_frame *frame, uint8_t batch);
+
+/**
+ * @brief Functions for adds sample to telemetry frame
+ *
+ * @retval frame length when the frame is complete and frame->buf is ready to
+ *         send, 0 while it is still filling
+ *
+ * The buffer stays valid until the next call.
+ */
+uint8_t lightranger3_frameAdd(T_lightranger3_frame *frame, T_lightranger3_sample *sample);
+
+/**
+ * @brief Functions for closes partly filled telemetry frame
+ *
+ * @retval frame length, 0 if the frame holds no sample
+ */
+uint8_t lightranger3_frameFlush(T_lightranger3_frame *frame);
+
+/**
+ * @brief Functions for attach latency histograms
+ *
+ * @param[in] hist   Histograms filled by every measurement from now on, 0
+ *                   detaches
+ *
+ * Each measurement adds its command write, ready wait and result readout
+ * time, measured with the tick source; nothing is recorded without one.
+ * Inserting is a few compares and one increment per phase.
+ */
+void lightranger3_attachHist(T_lightranger3_hist *hist);
+
+/**
+ * @brief Functions for clears latency histograms
+ */
+void lightranger3_histInit(T_lightranger3_hist *hist);
 
+/**
+ * @brief Functions for adds histograms of another sensor or run
+ *
+ * Counts saturate at 0xFFFF, the larger maximum is kept.
+ */
+void lightranger3_histMerge(T_lightranger3_hist *dst, const T_lightranger3_hist *src);
 
+/**
+ * @brief Functions for formats one histogram phase as a text line
+ *
+ * @param[in]  hist     Histograms
+ * @param[in]  phase    _LIGHTRANGER3_HIST_COMMAND, _READY or _READOUT
+ * @param[in]  sensor   Sensor tag written to the line, e.g. its address
+ * @param[out] buf      At least _LIGHTRANGER3_HIST_LINE_MAX characters
+ *
+ * @retval line length without the terminator
+ *
+ * "LR3H,sensor,phase,fail,maxUs,b0,...", one count per bucket, decimal, no
+ * line end. Send it
+ * with mikrobus_logWrite( buf, _LOG_LINE ) and parse it on the host with
+ * lightranger3_histParse.
+ */
+uint16_t lightranger3_histFormat(const T_lightranger3_hist *hist, uint8_t phase, uint8_t sensor, char *buf);
 
+                                                                       /** @} */
+/** @defgroup LIGHTRANGER3_DEV Multi-instance Functions */            /** @{ */
 
+/**
+ * @brief Binds sensor instance to the bus
+ *
+ * @param[out] dev      Sensor instance
+ * @param[in]  gpioObj  GPIO object of the mikroBUS the sensor is on
+ * @param[in]  i2cObj   I2C object of the bus the sensor is on
+ * @param[in]  slave    7 bit slave address of the sensor
+ *
+ * Any number of instances may share one I2C object. When instances are bound
+ * to different I2C objects the driver remaps the HAL before each transfer.
+ */
+void lightranger3_devI2cInit(T_lightranger3_dev *dev, T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P i2cObj, uint8_t slave);
+
+/**
+ * @brief Instance version of lightranger3_writeByte
+ */
+void lightranger3_devWriteByte(T_lightranger3_dev *dev, uint8_t reg, uint8_t _data);
+
+/**
+ * @brief Instance version of lightranger3_writeData
+ */
+void lightranger3_devWriteData(T_lightranger3_dev *dev, uint8_t reg, uint16_t _data);
+
+/**
+ * @brief Instance version of lightranger3_writeBlock
+ */
+void lightranger3_devWriteBlock(T_lightranger3_dev *dev, uint8_t reg, uint16_t *pData, uint8_t nRegs);
+
+/**
+ * @brief Instance version of lightranger3_readByte
+ */
+uint8_t lightranger3_devReadByte(T_lightranger3_dev *dev, uint8_t reg);
+
+/**
+ * @brief Instance version of lightranger3_readData
+ */
+uint16_t lightranger3_devReadData(T_lightranger3_dev *dev, uint8_t reg);
+
+/**
+ * @brief Instance version of lightranger3_readBlock
+ */
+void lightranger3_devReadBlock(T_lightranger3_dev *dev, uint8_t reg, uint8_t *pBuf, uint8_t nBytes);
+
+/**
+ * @brief Instance version of lightranger3_init
+ */
+uint8_t lightranger3_devInit(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_setStandbyMode
+ */
+uint8_t lightranger3_devSetStandbyMode(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_setOffMode
+ */
+uint8_t lightranger3_devSetOffMode(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_setOnMode
+ */
+uint8_t lightranger3_devSetOnMode(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_setMeasurementMode
+ */
+uint8_t lightranger3_devSetMeasurementMode(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_takeSingleMeasurement
+ */
+uint8_t lightranger3_devTakeSingleMeasurement(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_getDistance
+ */
+uint16_t lightranger3_devGetDistance(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_getConfidenceValue
+ */
+uint16_t lightranger3_devGetConfidenceValue(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_getSample
+ */
+void lightranger3_devGetSample(T_lightranger3_dev *dev, T_lightranger3_sample *sample);
+
+/**
+ * @brief Instance version of lightranger3_getDeviceID
+ */
+uint16_t lightranger3_devGetDeviceID(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_softReset
+ */
+uint8_t lightranger3_devSoftReset(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_invalidateCache
+ */
+void lightranger3_devInvalidateCache(T_lightranger3_dev *dev);
 
+/**
+ * @brief Instance version of lightranger3_setProfile
+ */
+uint8_t lightranger3_devSetProfile(T_lightranger3_dev *dev, const T_lightranger3_profile *profile);
+
+/**
+ * @brief Instance version of lightranger3_suspend
+ */
+uint8_t lightranger3_devSuspend(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_resume
+ */
+uint8_t lightranger3_devResume(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_measureWithRecovery
+ */
+uint8_t lightranger3_devMeasureWithRecovery(T_lightranger3_dev *dev, T_lightranger3_recovery *rec);
+
+/**
+ * @brief Instance version of lightranger3_getInterrupt
+ *
+ * Reads the INT pin of the GPIO object the instance was bound to.
+ */
+uint8_t lightranger3_devGetInterrupt(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_setReadyMode
+ */
+void lightranger3_devSetReadyMode(T_lightranger3_dev *dev, uint8_t mode);
+
+/**
+ * @brief Instance version of lightranger3_intHandler
+ */
+void lightranger3_devIntHandler(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_startTransition
+ */
+uint8_t lightranger3_devStartTransition(T_lightranger3_dev *dev, uint8_t mode);
+
+/**
+ * @brief Instance version of lightranger3_startMeasurement
+ */
+uint8_t lightranger3_devStartMeasurement(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_poll
+ */
+uint8_t lightranger3_devPoll(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_getResult
+ */
+uint8_t lightranger3_devGetResult(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_setTimeout
+ */
+void lightranger3_devSetTimeout(T_lightranger3_dev *dev, uint8_t mode, uint32_t us);
+
+/**
+ * @brief Instance version of lightranger3_getTransitionTime
+ */
+uint32_t lightranger3_devGetTransitionTime(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_getIntervalStats
+ */
+void lightranger3_devGetIntervalStats(T_lightranger3_dev *dev, T_lightranger3_intervalStats *stats);
+
+/**
+ * @brief Instance version of lightranger3_resetIntervalStats
+ */
+void lightranger3_devResetIntervalStats(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_startContinuous
+ */
+void lightranger3_devStartContinuous(T_lightranger3_dev *dev, T_lightranger3_ring *ring);
+
+/**
+ * @brief Instance version of lightranger3_stopContinuous
+ */
+void lightranger3_devStopContinuous(T_lightranger3_dev *dev);
+
+/**
+ * @brief Instance version of lightranger3_attachHist
+ */
+void lightranger3_devAttachHist(T_lightranger3_dev *dev, T_lightranger3_hist *hist);
+
+/**
+ * @brief Instance version of lightranger3_service
+ */
+uint8_t lightranger3_devService(T_lightranger3_dev *dev);
+
+/**
+ * @brief Reads I2C bus usage counters of the instance slave address
+ */
+uint8_t lightranger3_devGetBusStats(T_lightranger3_dev *dev, T_lightranger3_busStats *stats);
+
+/**
+ * @brief Binds scheduler to sensor instances
+ *
+ * @param[in] sched   Scheduler
+ * @param[in] devs    Initialized sensor instances, usually sharing one bus
+ * @param[in] count   Number of instances, up to 254
+ */
+void lightranger3_schedInit(T_lightranger3_sched *sched, T_lightranger3_dev **devs, uint8_t count);
+
+/**
+ * @brief Triggers a measurement on every sensor of the scheduler
+ */
+void lightranger3_schedStart(T_lightranger3_sched *sched);
+
+/**
+ * @brief Advances the next sensor in turn by one step
+ *
+ * @param[in]  sched    Scheduler
+ * @param[out] sample   Result of the completed measurement, may be 0
+ *
+ * @retval index of the sensor whose measurement has just completed, 0xFF if
+ *         none did in this call
+ *
+ * Sensors are visited round-robin, each call costs at most two bus
+ * transactions (status read and result read). A sensor that completes, or
+ * times out, has its result copied to sample, pushed to its ring if one is
+ * attached, and is re-triggered at once, so one sensor integrates while
+ * another is read out. Call it in a loop; with INT ready mode a sensor that
+ * is still integrating costs no bus traffic.
+ */
+uint8_t lightranger3_schedService(T_lightranger3_sched *sched, T_lightranger3_sample *sample);
+
+/**
+ * @brief Stops scheduling, pending measurements are abandoned
+ */
+void lightranger3_schedStop(T_lightranger3_sched *sched);
+
+/**
+ * @brief Moves sensor to another slave address
+ *
+ * @param[in] dev       Sensor instance, bound to the address it answers on now
+ * @param[in] address   New 7 bit slave address
+ *
+ * @retval 0 when the sensor answers with its device ID on the new address
+ *
+ * The address is written to I2C_INIT_CFG[15:9] (0 selects the power up
+ * address) and the instance is rebound to it. The setting does not survive
+ * a power cycle or lightranger3_softReset.
+ */
+uint8_t lightranger3_devSetAddress(T_lightranger3_dev *dev, uint8_t address);
+
+/**
+ * @brief Assigns unique addresses to identical sensors
+ *
+ * @param[in] devs           Instances bound to _LIGHTRANGER3_DEFAULT_ADDRESS,
+ *                           one per board, index as seen by enableFp
+ * @param[in] count          Number of boards
+ * @param[in] firstAddress   Address of board 0, board i gets firstAddress + i
+ * @param[in] enableFp       Enable line hook, may be 0 for a single board
+ *
+ * @retval number of boards provisioned, count on success, 0 when
+ *         firstAddress .. firstAddress + count - 1 leaves 0x08 - 0x77 or
+ *         contains _LIGHTRANGER3_DEFAULT_ADDRESS
+ *
+ * Disables every board, then enables them one by one, waits until the new
+ * board acknowledges and reports standby, at most 100 ms, and moves it off
+ * the power up address before the next one comes up.
+ */
+uint8_t lightranger3_provision(T_lightranger3_dev **devs, uint8_t count, uint8_t firstAddress, T_lightranger3_enableFp enableFp);
+
+/**
+ * @brief Finds sensors in a range of slave addresses
+ *
+ * @param[out] table      Instances bound to each sensor found, device ID cached
+ * @param[in]  maxCount   Size of table
+ * @param[in]  gpioObj    GPIO object the instances are bound to
+ * @param[in]  i2cObj     I2C object of the bus to scan
+ * @param[in]  first      First candidate address, at least 0x08
+ * @param[in]  last       Last candidate address, at most 0x77
+ *
+ * @retval number of sensors found
+ *
+ * Each candidate costs a single DEVICE_ID read. An address counts as a
+ * sensor when the transfer is acknowledged and returns 0xAD01 or 0xAD02.
+ */
+uint8_t lightranger3_enumerate(T_lightranger3_dev *table, uint8_t maxCount, T_LIGHTRANGER3_P gpioObj, T_LIGHTRANGER3_P i2cObj, uint8_t first, uint8_t last);
+
+/**
+ * @brief Starts duty cycled sampling
+ *
+ * @param[out] duty       Controller
+ * @param[in]  dev        Initialized sensor instance, 0 for the default one
+ * @param[in]  periodUs   Sample period in microseconds
+ *
+ * @retval 0 on success, 1 without a tick source, if a transition fails or
+ *         if none of 3 calibration measurements succeeds
+ *
+ * Measures how long the sensor takes to enter and leave standby and off
+ * and to take a measurement, then picks the state for the period. Needs
+ * lightranger3_setTickSource. Leaves the sensor on, the first sample is
+ * due at once.
+ */
+uint8_t lightranger3_dutyInit(T_lightranger3_duty *duty, T_lightranger3_dev *dev, uint32_t periodUs);
+
+/**
+ * @brief Changes sample period
+ *
+ * Takes effect after the next sample; the state used between samples is
+ * chosen again.
+ */
+void lightranger3_dutySetPeriod(T_lightranger3_duty *duty, uint32_t periodUs);
+
+/**
+ * @brief Takes the next sample on schedule
+ *
+ * @param[in]  duty     Controller
+ * @param[out] sample   Result, timestamped, may be 0
+ *
+ * @retval measurement error code as lightranger3_takeSingleMeasurement
+ *
+ * Waits, with Delay_1ms and Delay_10us, until the wake-up latency of the
+ * current state before the sample is due, wakes the sensor, measures on
+ * time and puts the sensor back into the deepest state whose enter time,
+ * wake-up latency and measurement time fit into the period (standby, then
+ * off, else it stays on). Wake-up latencies are measured again on every
+ * wake, so a sensor that slows down is moved to a shallower state. Time
+ * spent in every state is added to stateUs; the application may spend the
+ * time between calls as it likes, the sensor sleeps meanwhile.
+ */
+uint8_t lightranger3_dutySample(T_lightranger3_duty *duty, T_lightranger3_sample *sample);
 
                                                                        /** @} */
 #ifdef __cplusplus
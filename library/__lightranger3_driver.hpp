@@ -0,0 +1,876 @@
+/*
+    __lightranger3_driver.hpp
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+/**
+@file   __lightranger3_driver.hpp
+@brief    LightRanger_3 C++ Driver Template
+*/
+/**
+@defgroup   LIGHTRANGER3_CPP
+@brief      Header-only driver specialized on bus and pin policies
+@{
+
+The C driver reaches the bus through the HAL function pointers filled by
+hal_i2cMap and hal_gpioMap, one indirect call per I2C phase. This template
+takes the bus and the INT pin as policy classes instead, so every access is
+resolved at compile time and inlines down to the peripheral code of the
+policy. Register addresses and mode commands are the ones of
+__lightranger3_driver.c as constexpr values; register fields are typed
+(lightranger3::regmap) and checked for range and overlap at compile time.
+
+Bus policy, all static :
+
+    static uint8_t start();
+    static uint8_t write(uint8_t slave, uint8_t *buf, uint8_t n, uint8_t end);
+    static uint8_t read(uint8_t slave, uint8_t *buf, uint8_t n, uint8_t end);
+    static void    delay10us();
+
+end is lightranger3::END_RESTART or lightranger3::END_STOP, as in the HAL.
+
+Pin policy, static :
+
+    static uint8_t intGet();
+
+The C API in __lightranger3_driver.h is unchanged and remains the interface
+for C toolchains. Driver sends the same transactions as the blocking
+lightranger3_dev functions without a tick source, register shadow included;
+example/c/LINUX/Click_LightRanger_3_LINUX_parity.cpp compares the transfer
+logs of both on the simulator. Requires C++11, no exceptions, RTTI or
+standard library.
+
+*/
+/* -------------------------------------------------------------------------- */
+
+#include "stdint.h"
+
+#ifndef _LIGHTRANGER3_HPP_
+#define _LIGHTRANGER3_HPP_
+
+namespace lightranger3
+{
+
+/** @defgroup LIGHTRANGER3_CPP_VAR Variables */                      /** @{ */
+
+// Registers
+namespace reg
+{
+constexpr uint8_t ICSR             = 0x00;
+constexpr uint8_t IER              = 0x02;
+constexpr uint8_t CMD              = 0x04;
+constexpr uint8_t DEV_STATUS       = 0x06;
+constexpr uint8_t RESULT           = 0x08;
+constexpr uint8_t RESULT_CONFIG    = 0x0A;
+constexpr uint8_t CMD_CONFIG_A     = 0x0C;
+constexpr uint8_t CMD_CONFIG_B     = 0x0E;
+constexpr uint8_t HOST_TO_MCPU_MBX = 0x10;
+constexpr uint8_t MCPU_TO_HOST_MBX = 0x12;
+constexpr uint8_t PMU_CONFIG       = 0x14;
+constexpr uint8_t I2C_ADDR_PTR     = 0x18;
+constexpr uint8_t I2C_DATA_PTR     = 0x1A;
+constexpr uint8_t I2C_INIT_CFG     = 0x1C;
+constexpr uint8_t MCPU_PM_CTRL     = 0x1E;
+constexpr uint8_t HW_FW_CONFIG_0   = 0x20;
+constexpr uint8_t HW_FW_CONFIG_1   = 0x22;
+constexpr uint8_t HW_FW_CONFIG_2   = 0x24;
+constexpr uint8_t HW_FW_CONFIG_3   = 0x26;
+constexpr uint8_t DEVICE_ID        = 0x28;
+constexpr uint8_t PTCH_MEMORY_CFG  = 0x2A;
+}
+
+// Mode commands
+namespace mode
+{
+constexpr uint8_t STANDBY          = 0x90;
+constexpr uint8_t OFF              = 0x91;
+constexpr uint8_t ON               = 0x92;
+constexpr uint8_t MEASUREMENT      = 0x81;
+}
+
+constexpr uint8_t READY_POLL       = 0x00;
+constexpr uint8_t READY_INT        = 0x01;
+
+constexpr uint8_t DEFAULT_ADDRESS  = 0x4C;
+
+// Bus policy end modes, same values as END_MODE_RESTART / END_MODE_STOP
+constexpr uint8_t END_RESTART      = 0;
+constexpr uint8_t END_STOP         = 1;
+
+constexpr uint8_t OK               = 0;
+constexpr uint8_t ERROR            = 1;
+
+// I2C_INIT_CFG: [15:9] slave address, [7:0] interface setup
+constexpr uint16_t I2C_INIT_CFG_SETUP = 0x0065;
+
+// Largest register block written in one transaction
+constexpr uint8_t MAX_BLOCK_REGS   = 8;
+
+constexpr uint8_t CMD_SW_RESET     = 0x40;
+// CMD_CONFIG_A other than its reset default of 0, the balanced profile's
+constexpr uint16_t RESET_MARK      = 0xE100;
+
+// Transition budgets in us and status read backoff in 10 us steps
+constexpr uint32_t TIMEOUT_MODE_US  = 10000;
+constexpr uint32_t TIMEOUT_MEAS_US  = 100000;
+constexpr uint32_t TIMEOUT_RESET_US = 100000;
+constexpr uint8_t BACKOFF_MIN      = 1;
+constexpr uint8_t BACKOFF_MAX      = 32;
+
+                                                                       /** @} */
+/** @defgroup LIGHTRANGER3_CPP_MAP Register Map */                    /** @{ */
+
+// Register access modes
+constexpr uint8_t RO = 0x01;
+constexpr uint8_t WO = 0x02;
+constexpr uint8_t RW = 0x03;
+
+/**
+ * @brief 16-bit register at an even address of the RFD77402 map
+ */
+template< uint8_t Addr, uint8_t Access >
+struct Register
+{
+    static_assert( (Addr & 1) == 0 && Addr <= reg::PTCH_MEMORY_CFG, "register outside the RFD77402 map" );
+    static_assert( Access == RO || Access == WO || Access == RW, "unknown access mode" );
+
+    static constexpr uint8_t address = Addr;
+    static constexpr uint8_t access  = Access;
+};
+
+// Narrowest type for a field value
+template< bool Narrow >
+struct FieldType
+{
+    typedef uint16_t type;
+};
+
+template<>
+struct FieldType< true >
+{
+    typedef uint8_t type;
+};
+
+/**
+ * @brief Bit field of a register
+ *
+ * get and put fold to the same shift and mask as hand-written code; using
+ * get on a write only register or put on a read only one does not compile.
+ */
+template< class Reg, uint8_t Shift, uint8_t Width >
+struct Field
+{
+    static_assert( Width >= 1 && Shift + Width <= 16, "field outside its 16-bit register" );
+
+    typedef Reg reg;
+    typedef typename FieldType< Width <= 8 >::type value_type;
+    static constexpr uint16_t mask = (uint16_t)(0xFFFFu >> (16 - Width));
+    static constexpr uint16_t bits = (uint16_t)(mask << Shift);
+
+    template< class T >
+    static constexpr value_type get(T value)
+    {
+        static_assert( Reg::access & RO, "field of a write only register" );
+        return (value_type)((value >> Shift) & mask);
+    }
+
+    static constexpr uint16_t put(uint16_t value)
+    {
+        static_assert( Reg::access & WO, "field of a read only register" );
+        return (uint16_t)((value & mask) << Shift);
+    }
+};
+
+/**
+ * @brief Field list of one register, rejects overlapping fields
+ */
+template< class Reg, class... Fields >
+struct Layout;
+
+template< class Reg >
+struct Layout< Reg >
+{
+    static constexpr uint16_t bits  = 0;
+    static constexpr bool     valid = true;
+};
+
+template< class Reg, class F, class... Rest >
+struct Layout< Reg, F, Rest... >
+{
+    static_assert( F::reg::address == Reg::address, "field of another register" );
+    static_assert( (F::bits & Layout< Reg, Rest... >::bits) == 0, "overlapping fields" );
+
+    static constexpr uint16_t bits  = F::bits | Layout< Reg, Rest... >::bits;
+    static constexpr bool     valid = Layout< Reg, Rest... >::valid;
+};
+
+namespace regmap
+{
+typedef Register< reg::ICSR, RW >           ICSR;
+typedef Register< reg::DEV_STATUS, RO >     DEV_STATUS;
+typedef Register< reg::RESULT, RO >         RESULT;
+typedef Register< reg::RESULT_CONFIG, RW >  RESULT_CONFIG;
+typedef Register< reg::I2C_INIT_CFG, RW >   I2C_INIT_CFG;
+
+typedef Field< ICSR, 4, 1 >                 ICSR_RESULT;            // Result ready
+typedef Field< DEV_STATUS, 0, 5 >           DEV_STATUS_STATE;       // MCPU state
+typedef Field< RESULT, 0, 1 >               RESULT_VALID;
+typedef Field< RESULT, 2, 11 >              RESULT_DISTANCE;        // mm
+typedef Field< RESULT, 13, 2 >              RESULT_ERROR;
+typedef Field< RESULT_CONFIG, 4, 11 >       RESULT_CONFIG_CONFIDENCE;
+typedef Field< I2C_INIT_CFG, 0, 8 >         I2C_INIT_CFG_SETUP;
+typedef Field< I2C_INIT_CFG, 9, 7 >         I2C_INIT_CFG_ADDRESS;
+
+static_assert( Layout< RESULT, RESULT_VALID, RESULT_DISTANCE, RESULT_ERROR >::valid, "RESULT" );
+static_assert( Layout< I2C_INIT_CFG, I2C_INIT_CFG_SETUP, I2C_INIT_CFG_ADDRESS >::valid, "I2C_INIT_CFG" );
+}
+
+// DEV_STATUS_STATE values
+constexpr uint16_t STATE_STANDBY = 0x00;
+constexpr uint16_t STATE_OFF     = 0x10;
+constexpr uint16_t STATE_ON      = 0x18;
+
+// Any of RESULT [14:0] set, an all zero result was never written
+constexpr uint16_t DISTANCE_IS_GOOD = 0x7FFF;
+
+constexpr uint16_t i2cInitCfg(uint8_t address)
+{
+    return address == DEFAULT_ADDRESS ? I2C_INIT_CFG_SETUP
+                                      : (uint16_t)(regmap::I2C_INIT_CFG_ADDRESS::put( address ) | I2C_INIT_CFG_SETUP);
+}
+
+// Shadowed registers, same slots as the C driver: ICSR, IER, CMD_CONFIG_A,
+// CMD_CONFIG_B, PMU_CONFIG, I2C_INIT_CFG, HW_FW_CONFIG_0 .. HW_FW_CONFIG_3
+constexpr uint8_t SHADOW_REGS = 10;
+constexpr uint8_t NO_SLOT     = 0xFF;
+
+constexpr uint8_t shadowSlot(uint8_t r)
+{
+    return (r & 0xFE) <= reg::IER ? (uint8_t)((r & 0xFE) >> 1)
+         : ((r & 0xFE) == reg::CMD_CONFIG_A || (r & 0xFE) == reg::CMD_CONFIG_B)
+             ? (uint8_t)(2 + (((r & 0xFE) - reg::CMD_CONFIG_A) >> 1))
+         : (r & 0xFE) == reg::PMU_CONFIG ? 4
+         : (r & 0xFE) == reg::I2C_INIT_CFG ? 5
+         : ((r & 0xFE) >= reg::HW_FW_CONFIG_0 && (r & 0xFE) <= reg::HW_FW_CONFIG_3)
+             ? (uint8_t)(6 + (((r & 0xFE) - reg::HW_FW_CONFIG_0) >> 1))
+         : NO_SLOT;
+}
+
+                                                                       /** @} */
+/** @defgroup LIGHTRANGER3_CPP_TYPES Types */                         /** @{ */
+
+/**
+ * @brief Measurement profile, same words as T_lightranger3_profile
+ */
+struct Profile
+{
+    uint16_t    cmdConfig[ 2 ];     // CMD_CONFIG_A, CMD_CONFIG_B
+    uint16_t    hwFwConfig[ 4 ];    // HW_FW_CONFIG_0 .. HW_FW_CONFIG_3
+};
+
+// The profiles of __lightranger3_driver.c, balanced is the init default
+// and the only supported one, the EXP profiles are experimental;
+// HW_FW_CONFIG is module calibration and the same in all of them
+constexpr Profile PROFILE_EXP_FAST_SHORT = { { 0x6100, 0x30FF }, { 0x07D0, 0x5008, 0xA041, 0x45D4 } };
+constexpr Profile PROFILE_BALANCED   = { { 0xE100, 0x10FF }, { 0x07D0, 0x5008, 0xA041, 0x45D4 } };
+constexpr Profile PROFILE_EXP_LONG_RANGE = { { 0xF200, 0x00FF }, { 0x07D0, 0x5008, 0xA041, 0x45D4 } };
+
+/**
+ * @brief Pin policy for sensors used in poll mode only
+ */
+struct NoPin
+{
+    static uint8_t intGet() { return 0; }
+};
+
+/**
+ * @brief Sensor driver
+ *
+ * @tparam Bus     bus policy
+ * @tparam Pin     INT pin policy
+ * @tparam Slave   7-bit slave address, fixed at compile time
+ *
+ * One object per sensor. Behaves like T_lightranger3_dev driven through
+ * the blocking lightranger3_dev functions without a tick source: the
+ * transition budget is counted from the backoff delays, and register
+ * writes the shadow already holds are skipped the same way.
+ */
+template< class Bus, class Pin = NoPin, uint8_t Slave = DEFAULT_ADDRESS >
+class Driver
+{
+public:
+
+    Driver()
+        : distance_( 0 ), confidenceValue_( 0 ), deviceId_( 0 ),
+          errorCode_( ERROR ), readyMode_( READY_POLL ), intFlag_( 0 ), mode_( 0 ),
+          shadowValid_( 0 ), loaded_( 0 ), profile_( &PROFILE_BALANCED )
+    {
+    }
+
+    static constexpr uint8_t slave() { return Slave; }
+
+    void writeByte(uint8_t r, uint8_t data)
+    {
+        uint8_t writeReg[ 2 ] = { r, data };
+
+        // Half a register changed, the shadowed value is no longer known
+        if (shadowSlot( r ) != NO_SLOT)
+        {
+            shadowValid_ &= ~(1 << shadowSlot( r ));
+        }
+        commandSent( r, data );
+
+        Bus::start();
+        Bus::write( Slave, writeReg, 2, END_STOP );
+    }
+
+    void writeData(uint8_t r, uint16_t data)
+    {
+        writeDataTo( Slave, r, data );
+    }
+
+    /**
+     * @brief Writes N adjacent registers in one transaction
+     */
+    template< uint8_t N >
+    void writeBlock(uint8_t r, const uint16_t (&data)[ N ])
+    {
+        static_assert( N >= 1 && N <= MAX_BLOCK_REGS, "register block of 1 to 8 registers" );
+
+        writeRegs( r, data, N );
+    }
+
+    uint8_t readByte(uint8_t r)
+    {
+        uint8_t readReg[ 1 ];
+
+        readBlock( r, readReg, 1 );
+        return readReg[ 0 ];
+    }
+
+    uint16_t readData(uint8_t r)
+    {
+        uint8_t readReg[ 2 ];
+
+        readBlock( r, readReg, 2 );
+        return ((uint16_t)readReg[ 1 ] << 8) | readReg[ 0 ];
+    }
+
+    /**
+     * @brief Reads one field with a 16-bit register read
+     */
+    template< class F >
+    uint16_t readField()
+    {
+        return F::get( readData( F::reg::address ) );
+    }
+
+    /**
+     * @brief Read-modify-write of one field
+     */
+    template< class F >
+    void writeField(uint16_t value)
+    {
+        uint16_t old;
+
+        old = readData( F::reg::address );
+        writeData( F::reg::address, (uint16_t)((old & ~F::bits) | F::put( value )) );
+    }
+
+    void readBlock(uint8_t r, uint8_t *pBuf, uint8_t nBytes)
+    {
+        uint8_t writeReg[ 1 ] = { r };
+
+        Bus::start();
+        Bus::write( Slave, writeReg, 1, END_RESTART );
+        Bus::read( Slave, pBuf, nBytes, END_STOP );
+    }
+
+    /**
+     * @brief Configures the sensor with the current profile, same sequence as
+     *        lightranger3_devInit
+     */
+    uint8_t init()
+    {
+        const uint16_t icsr[ 2 ] = { 0x05, 0x01 };
+
+        // Read every time, not the cached ID: a sensor that went away must fail here
+        if (probeId() != OK)
+        {
+            return ERROR;
+        }
+        if (setStandbyMode() != OK)
+        {
+            return ERROR;
+        }
+        // Address auto-increment first, the block writes below depend on it
+        writeCached( reg::I2C_INIT_CFG, i2cInitCfg( Slave ) );
+        writeBlockCached( reg::ICSR, icsr, 2 );
+        writeCached( reg::PMU_CONFIG, 0x0500 );
+        if (setOffMode() != OK)
+        {
+            return ERROR;
+        }
+        writeCached( reg::PMU_CONFIG, 0x0600 );
+        if (setOnMode() != OK)
+        {
+            return ERROR;
+        }
+        writeBlockCached( reg::CMD_CONFIG_A, profile_->cmdConfig, 2 );
+        writeBlockCached( reg::HW_FW_CONFIG_0, profile_->hwFwConfig, 4 );
+        loaded_ = 1;
+
+        return OK;
+    }
+
+    /**
+     * @brief Selects the measurement profile, as lightranger3_devSetProfile
+     *
+     * Taken by the next init; on an initialized sensor only the registers
+     * that differ from the shadow are written. The profile must outlive the
+     * driver.
+     */
+    uint8_t setProfile(const Profile *profile)
+    {
+        profile_ = profile;
+        if (loaded_)
+        {
+            writeBlockCached( reg::CMD_CONFIG_A, profile->cmdConfig, 2 );
+            writeBlockCached( reg::HW_FW_CONFIG_0, profile->hwFwConfig, 4 );
+        }
+        return OK;
+    }
+
+    uint8_t setStandbyMode() { return transition( mode::STANDBY, TIMEOUT_MODE_US ); }
+    uint8_t setOffMode()     { return transition( mode::OFF, TIMEOUT_MODE_US ); }
+    uint8_t setOnMode()      { return transition( mode::ON, TIMEOUT_MODE_US ); }
+
+    /**
+     * @brief Takes one measurement
+     *
+     * @retval error code of the result, ERROR on timeout
+     */
+    uint8_t takeSingleMeasurement()
+    {
+        errorCode_ = ERROR;
+        if (transition( mode::MEASUREMENT, TIMEOUT_MEAS_US ) != OK)
+        {
+            return ERROR;
+        }
+        readResult();
+        return errorCode_;
+    }
+
+    uint16_t getDeviceID()
+    {
+        uint16_t id;
+
+        if (deviceId_ != 0)
+        {
+            return deviceId_;
+        }
+        id = readData( reg::DEVICE_ID );
+        if (id == 0xAD02 || id == 0xAD01)
+        {
+            deviceId_ = id;
+        }
+        return id;
+    }
+
+    /**
+     * @brief Moves a sensor answering on the power up address to Slave, as
+     *        lightranger3_devSetAddress
+     *
+     * @retval OK once the sensor answers on Slave with a known DEVICE_ID
+     */
+    uint8_t setAddress()
+    {
+        // Acknowledged on the power up address, takes effect from the next START
+        writeDataTo( DEFAULT_ADDRESS, reg::I2C_INIT_CFG, i2cInitCfg( Slave ) );
+        deviceId_ = 0;
+
+        return probeId();
+    }
+
+    /**
+     * @brief Resets the sensor and waits until it is back, as
+     *        lightranger3_devSoftReset
+     *
+     * @retval OK, ERROR when the sensor is not back in standby within
+     *         TIMEOUT_RESET_US or does not take Slave again
+     */
+    uint8_t softReset()
+    {
+        // A CMD_CONFIG_A of 0 must mean the reset ran, so one not known to be
+        // set gets a mark first
+        if ((shadowValid_ & (1 << shadowSlot( reg::CMD_CONFIG_A ))) == 0 || shadow_[ shadowSlot( reg::CMD_CONFIG_A ) ] == 0)
+        {
+            writeData( reg::CMD_CONFIG_A, RESET_MARK );
+        }
+        // Also drops the whole register cache
+        writeByte( reg::CMD, CMD_SW_RESET );
+
+        // The reset also clears I2C_INIT_CFG, the sensor comes back on the power up address
+        if (waitStandby( DEFAULT_ADDRESS, 1 ) != OK)
+        {
+            return ERROR;
+        }
+        if (Slave != DEFAULT_ADDRESS)
+        {
+            return setAddress();
+        }
+        return OK;
+    }
+
+    void invalidateCache()
+    {
+        deviceId_    = 0;
+        mode_        = 0;
+        shadowValid_ = 0;
+        loaded_      = 0;
+    }
+
+    uint16_t getDistance() const        { return distance_; }
+    uint16_t getConfidenceValue() const { return confidenceValue_; }
+    uint8_t  getResult() const          { return errorCode_; }
+    uint8_t  getInterrupt() const       { return Pin::intGet(); }
+
+    void setReadyMode(uint8_t readyMode) { readyMode_ = readyMode; }
+    void intHandler()                    { intFlag_ = 1; }
+
+private:
+
+    void writeDataTo(uint8_t address, uint8_t r, uint16_t data)
+    {
+        uint8_t writeReg[ 3 ] = { r, (uint8_t)data, (uint8_t)(data >> 8) };
+
+        shadowStore( r, data );
+        commandSent( r, writeReg[ 1 ] );
+
+        Bus::start();
+        Bus::write( address, writeReg, 3, END_STOP );
+    }
+
+    void writeRegs(uint8_t r, const uint16_t *pData, uint8_t nRegs)
+    {
+        uint8_t writeReg[ 1 + 2 * MAX_BLOCK_REGS ];
+        uint8_t burst;
+        uint8_t i;
+
+        // Longer blocks go out as consecutive bursts of MAX_BLOCK_REGS registers
+        while (nRegs != 0)
+        {
+            burst = nRegs > MAX_BLOCK_REGS ? MAX_BLOCK_REGS : nRegs;
+            writeReg[ 0 ] = r;
+            for (i = 0; i < burst; i++)
+            {
+                writeReg[ 1 + 2 * i ] = (uint8_t)pData[ i ];
+                writeReg[ 2 + 2 * i ] = (uint8_t)(pData[ i ] >> 8);
+                shadowStore( r + 2 * i, pData[ i ] );
+            }
+            Bus::start();
+            Bus::write( Slave, writeReg, 1 + 2 * burst, END_STOP );
+
+            r     += 2 * burst;
+            pData += burst;
+            nRegs -= burst;
+        }
+    }
+
+    void shadowStore(uint8_t r, uint16_t value)
+    {
+        if (shadowSlot( r ) != NO_SLOT)
+        {
+            shadow_[ shadowSlot( r ) ] = value;
+            shadowValid_ |= (1 << shadowSlot( r ));
+        }
+    }
+
+    uint8_t shadowMatch(uint8_t r, uint16_t value) const
+    {
+        return shadowSlot( r ) != NO_SLOT && (shadowValid_ & (1 << shadowSlot( r ))) != 0
+               && shadow_[ shadowSlot( r ) ] == value;
+    }
+
+    void commandSent(uint8_t r, uint8_t cmd)
+    {
+        if (r != reg::CMD)
+        {
+            return;
+        }
+        // Any command moves the sensor away from the cached mode, a reset also
+        // brings every register back to its default
+        if (cmd == CMD_SW_RESET)
+        {
+            invalidateCache();
+        }
+        else
+        {
+            mode_ = 0;
+        }
+    }
+
+    void writeCached(uint8_t r, uint16_t value)
+    {
+        if (!shadowMatch( r, value ))
+        {
+            writeDataTo( Slave, r, value );
+        }
+    }
+
+    void writeBlockCached(uint8_t r, const uint16_t *pData, uint8_t nRegs)
+    {
+        // Trim registers the sensor already holds from both ends, the
+        // remaining span goes out as one block
+        while (nRegs != 0 && shadowMatch( r, pData[ 0 ] ))
+        {
+            r += 2;
+            pData++;
+            nRegs--;
+        }
+        while (nRegs != 0 && shadowMatch( r + 2 * (nRegs - 1), pData[ nRegs - 1 ] ))
+        {
+            nRegs--;
+        }
+        if (nRegs != 0)
+        {
+            writeRegs( r, pData, nRegs );
+        }
+    }
+
+    uint8_t probeId()
+    {
+        uint8_t  writeReg[ 1 ] = { reg::DEVICE_ID };
+        uint8_t  readReg[ 2 ]  = { 0, 0 };
+        uint16_t id;
+
+        // Unlike readData, a NACK must not be read as data here
+        if (Bus::start() != 0 || Bus::write( Slave, writeReg, 1, END_RESTART ) != 0
+            || Bus::read( Slave, readReg, 2, END_STOP ) != 0)
+        {
+            return ERROR;
+        }
+        id = ((uint16_t)readReg[ 1 ] << 8) | readReg[ 0 ];
+        if (id != 0xAD02 && id != 0xAD01)
+        {
+            return ERROR;
+        }
+        deviceId_ = id;
+
+        return OK;
+    }
+
+    uint8_t readChecked(uint8_t address, uint8_t r, uint16_t *value)
+    {
+        uint8_t writeReg[ 1 ] = { r };
+        uint8_t readReg[ 2 ];
+
+        // NACKed while the sensor reboots, an untouched buffer would read as data
+        if (Bus::start() != 0 || Bus::write( address, writeReg, 1, END_RESTART ) != 0
+            || Bus::read( address, readReg, 2, END_STOP ) != 0)
+        {
+            return ERROR;
+        }
+        *value = ((uint16_t)readReg[ 1 ] << 8) | readReg[ 0 ];
+
+        return OK;
+    }
+
+    uint8_t waitStandby(uint8_t address, uint8_t afterReset)
+    {
+        uint32_t waitUs  = 0;
+        uint16_t value;
+        uint8_t  backoff = BACKOFF_MIN;
+        uint8_t  started = !afterReset;
+        uint8_t  i;
+
+        // Standby right after the reset command may be the one from before,
+        // it counts once the reset showed as a NACK, another state or
+        // CMD_CONFIG_A back at 0
+        for (;;)
+        {
+            if (readChecked( address, reg::DEV_STATUS, &value ) != OK
+                || regmap::DEV_STATUS_STATE::get( value ) != STATE_STANDBY)
+            {
+                started = 1;
+            }
+            else if (started)
+            {
+                return OK;
+            }
+            else if (readChecked( address, reg::CMD_CONFIG_A, &value ) != OK)
+            {
+                started = 1;
+            }
+            else if (value == 0)
+            {
+                return OK;
+            }
+            waitUs += 10 * (uint32_t)backoff;
+            if (waitUs >= TIMEOUT_RESET_US)
+            {
+                return ERROR;
+            }
+            for (i = 0; i < backoff; i++)
+            {
+                Bus::delay10us();
+            }
+            if (backoff < BACKOFF_MAX)
+            {
+                backoff <<= 1;
+            }
+        }
+    }
+
+    uint8_t isReady(uint8_t target)
+    {
+        uint16_t status;
+
+        if (target == mode::MEASUREMENT)
+        {
+            if (readyMode_ == READY_INT)
+            {
+                return intFlag_ != 0 || Pin::intGet() != 0;
+            }
+            // The flag sits in the low byte, one byte read as in the C driver
+            return regmap::ICSR_RESULT::get( readByte( reg::ICSR ) ) != 0;
+        }
+
+        status = readField< regmap::DEV_STATUS_STATE >();
+        if (target == mode::STANDBY)
+        {
+            return status == STATE_STANDBY;
+        }
+        if (target == mode::OFF)
+        {
+            return status == STATE_OFF;
+        }
+        return status == STATE_ON;
+    }
+
+    uint8_t transition(uint8_t target, uint32_t timeoutUs)
+    {
+        uint32_t waitUs = 0;
+        uint8_t  backoff = BACKOFF_MIN;
+        uint8_t  i;
+
+        // Already there, nothing to send
+        if (target != mode::MEASUREMENT && mode_ == target)
+        {
+            return OK;
+        }
+        intFlag_ = 0;
+        writeByte( reg::CMD, target );
+
+        while (!isReady( target ))
+        {
+            waitUs += 10 * (uint32_t)backoff;
+            if (waitUs >= timeoutUs)
+            {
+                return ERROR;
+            }
+            // Doubled before the wait, as lightranger3_devPoll does
+            if (backoff < BACKOFF_MAX)
+            {
+                backoff <<= 1;
+            }
+            for (i = 0; i < backoff; i++)
+            {
+                Bus::delay10us();
+            }
+        }
+        // The MCPU drops back to on once the result is latched
+        mode_ = target == mode::MEASUREMENT ? mode::ON : target;
+        return OK;
+    }
+
+    void readResult()
+    {
+        uint8_t  readReg[ 4 ];
+        uint16_t readValue;
+        uint16_t confidenceRegister;
+
+        // RESULT and RESULT_CONFIG are adjacent, fetch both in one transaction
+        readBlock( reg::RESULT, readReg, 4 );
+        readValue          = ((uint16_t)readReg[ 1 ] << 8) | readReg[ 0 ];
+        confidenceRegister = ((uint16_t)readReg[ 3 ] << 8) | readReg[ 2 ];
+
+        if (readValue & DISTANCE_IS_GOOD)
+        {
+            errorCode_ = regmap::RESULT_ERROR::get( readValue );
+            if (errorCode_ == 0)
+            {
+                distance_        = regmap::RESULT_DISTANCE::get( readValue );
+                confidenceValue_ = regmap::RESULT_CONFIG_CONFIDENCE::get( confidenceRegister );
+            }
+        }
+        else
+        {
+            errorCode_ = ERROR;
+        }
+    }
+
+    uint16_t            distance_;
+    uint16_t            confidenceValue_;
+    uint16_t            deviceId_;
+    uint8_t             errorCode_;
+    uint8_t             readyMode_;
+    volatile uint8_t    intFlag_;
+    uint8_t             mode_;
+    uint16_t            shadow_[ SHADOW_REGS ];
+    uint16_t            shadowValid_;
+    uint8_t             loaded_;
+    const Profile       *profile_;
+};
+
+                                                                       /** @} */
+} // namespace lightranger3
+
+#endif
+                                                                       /** @} */
+/* -------------------------------------------------------------------------- */
+/*
+  __lightranger3_driver.hpp
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */
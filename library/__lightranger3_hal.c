@@ -47,6 +47,16 @@
                  #define   __HAL_I2C__                            /**<     @macro __HAL_I2C__  @brief I2C HAL selector */
 //               #define   __HAL_UART__                           /**<     @macro __HAL_UART__  @brief UART HAL selector */                          
 
+//               #define   __HAL_I2C_STATS__                      /**<     @macro __HAL_I2C_STATS__  @brief I2C call counters and timing */
+#ifndef __HAL_I2C_STATS_SLOTS__
+                 #define   __HAL_I2C_STATS_SLOTS__    8           /**<     @macro __HAL_I2C_STATS_SLOTS__  @brief Slave addresses tracked separately */
+#endif
+#if defined( __linux__ ) && defined( __GNUC__ )
+                 #define   __HAL_THREAD__    __thread             /**<     @macro __HAL_THREAD__  @brief Bus state kept per thread, one thread per bus needs no locking */
+#else
+                 #define   __HAL_THREAD__
+#endif
+
 // #define   __AN_PIN_INPUT__          0
 // #define   __RST_PIN_INPUT__         1
 // #define   __CS_PIN_INPUT__          2
@@ -128,6 +138,13 @@ static void hal_spiTransfer(uint8_t *pIn, uint8_t *pOut, uint16_t nBytes);
 
 /** @defgroup LIGHTRANGER3_HAL_I2C HAL I2C Interface */               /** @{ */
 
+#ifdef __HAL_I2C_STATS__
+// Back-end implements the raw calls, instrumented wrappers are defined below
+#define hal_i2cStart    hal_i2cStartRaw
+#define hal_i2cWrite    hal_i2cWriteRaw
+#define hal_i2cRead     hal_i2cReadRaw
+#endif
+
 /**
  * @brief Map I2C Function Pointers
  */
@@ -448,6 +465,174 @@ static void hal_gpioMap(T_HAL_P gpioObj)
 #endif
 #endif
 
+#ifdef __linux__
+#include "__HAL_LINUX.c"
+#endif
+
+#ifdef __HAL_I2C__
+#ifdef __HAL_I2C_STATS__
+
+/** @defgroup LIGHTRANGER3_HAL_I2C_STATS HAL I2C Instrumentation */   /** @{ */
+
+#undef hal_i2cStart
+#undef hal_i2cWrite
+#undef hal_i2cRead
+
+typedef uint32_t (*T_hal_tickFp)();
+
+/**
+ * @brief I2C call counters
+ *
+ * Elapsed ticks are summed over every call and come from the tick source
+ * registered in hal_i2cStatsTick; they stay 0 when no source is set.
+ */
+typedef struct
+{
+    uint32_t    starts;
+    uint32_t    writes;
+    uint32_t    reads;
+    uint32_t    bytesWritten;
+    uint32_t    bytesRead;
+    uint32_t    errors;
+    uint32_t    ticks;
+
+}T_hal_i2cStats;
+
+static T_hal_tickFp     hal_i2cStatsTick = 0;
+static __HAL_THREAD__ T_hal_i2cStats   hal_i2cStatsTotal;
+static __HAL_THREAD__ T_hal_i2cStats   hal_i2cStatsSlot[ __HAL_I2C_STATS_SLOTS__ ];
+static __HAL_THREAD__ uint8_t          hal_i2cStatsAddr[ __HAL_I2C_STATS_SLOTS__ ];
+static __HAL_THREAD__ uint8_t          hal_i2cStatsUsed = 0;
+
+static void hal_i2cStatsClear(T_hal_i2cStats *st)
+{
+    st->starts       = 0;
+    st->writes       = 0;
+    st->reads        = 0;
+    st->bytesWritten = 0;
+    st->bytesRead    = 0;
+    st->errors       = 0;
+    st->ticks        = 0;
+}
+
+static uint32_t hal_i2cStatsNow()
+{
+    if (hal_i2cStatsTick == 0)
+    {
+        return 0;
+    }
+    return hal_i2cStatsTick();
+}
+
+/**
+ * @brief Returns counters of one slave address
+ *
+ * @retval 0 when the address table is full and the address is not in it
+ */
+static T_hal_i2cStats* hal_i2cStatsFind(uint8_t slaveAddress)
+{
+    uint8_t i;
+
+    for (i = 0; i < hal_i2cStatsUsed; i++)
+    {
+        if (hal_i2cStatsAddr[ i ] == slaveAddress)
+        {
+            return &hal_i2cStatsSlot[ i ];
+        }
+    }
+    if (hal_i2cStatsUsed == __HAL_I2C_STATS_SLOTS__)
+    {
+        return 0;
+    }
+    hal_i2cStatsAddr[ hal_i2cStatsUsed ] = slaveAddress;
+    hal_i2cStatsClear( &hal_i2cStatsSlot[ hal_i2cStatsUsed ] );
+
+    return &hal_i2cStatsSlot[ hal_i2cStatsUsed++ ];
+}
+
+static void hal_i2cStatsReset()
+{
+    hal_i2cStatsClear( &hal_i2cStatsTotal );
+    hal_i2cStatsUsed = 0;
+}
+
+static void hal_i2cStatsAdd(T_hal_i2cStats *st, uint8_t isRead, uint16_t nBytes, int res, uint32_t ticks)
+{
+    if (isRead)
+    {
+        st->reads++;
+        st->bytesRead += nBytes;
+    }
+    else
+    {
+        st->writes++;
+        st->bytesWritten += nBytes;
+    }
+    if (res != 0)
+    {
+        st->errors++;
+    }
+    st->ticks += ticks;
+}
+
+static int hal_i2cStart()
+{
+    uint32_t t0;
+    int      res;
+
+    t0  = hal_i2cStatsNow();
+    res = hal_i2cStartRaw();
+    hal_i2cStatsTotal.starts++;
+    if (res != 0)
+    {
+        hal_i2cStatsTotal.errors++;
+    }
+    hal_i2cStatsTotal.ticks += hal_i2cStatsNow() - t0;
+
+    return res;
+}
+
+static int hal_i2cWrite(uint8_t slaveAddress, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode)
+{
+    T_hal_i2cStats *st;
+    uint32_t t0;
+    int      res;
+
+    t0  = hal_i2cStatsNow();
+    res = hal_i2cWriteRaw( slaveAddress, pBuf, nBytes, endMode );
+    t0  = hal_i2cStatsNow() - t0;
+
+    hal_i2cStatsAdd( &hal_i2cStatsTotal, 0, nBytes, res, t0 );
+    st = hal_i2cStatsFind( slaveAddress );
+    if (st != 0)
+    {
+        hal_i2cStatsAdd( st, 0, nBytes, res, t0 );
+    }
+    return res;
+}
+
+static int hal_i2cRead(uint8_t slaveAddress, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode)
+{
+    T_hal_i2cStats *st;
+    uint32_t t0;
+    int      res;
+
+    t0  = hal_i2cStatsNow();
+    res = hal_i2cReadRaw( slaveAddress, pBuf, nBytes, endMode );
+    t0  = hal_i2cStatsNow() - t0;
+
+    hal_i2cStatsAdd( &hal_i2cStatsTotal, 1, nBytes, res, t0 );
+    st = hal_i2cStatsFind( slaveAddress );
+    if (st != 0)
+    {
+        hal_i2cStatsAdd( st, 1, nBytes, res, t0 );
+    }
+    return res;
+}
+                                                                       /** @} */
+#endif
+#endif
+
 /* -------------------------------------------------------------------------- */
 /*
   __lightranger3_hal.c
@@ -0,0 +1,337 @@
+/*
+    __lightranger3_service.c
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+#include <time.h>
+
+#include "__lightranger3_service.h"
+
+/* ------------------------------------------------------------------- MACROS */
+
+#define SVC_QUEUE_MASK  ( _LIGHTRANGER3_SVC_QUEUE_SIZE - 1 )
+
+// HAL delay, also advances the simulator clock of the calling thread
+void Delay_10us();
+
+/* -------------------------------------------- PRIVATE FUNCTION DECLARATIONS */
+
+static void _queueInit(T_lightranger3_svcQueue *q);
+static uint8_t _queuePush(T_lightranger3_svcQueue *q, T_lightranger3_svcSample *sample);
+static uint8_t _queuePop(T_lightranger3_svcQueue *q, T_lightranger3_svcSample *sample);
+static void* _svcWorker(void *arg);
+
+/* --------------------------------------------- PRIVATE FUNCTION DEFINITIONS */
+
+static void _queueInit(T_lightranger3_svcQueue *q)
+{
+    uint32_t i;
+
+    for (i = 0; i < _LIGHTRANGER3_SVC_QUEUE_SIZE; i++)
+    {
+        __atomic_store_n( &q->cell[ i ].seq, i, __ATOMIC_RELAXED );
+    }
+    __atomic_store_n( &q->enqueuePos, 0, __ATOMIC_RELAXED );
+    __atomic_store_n( &q->dequeuePos, 0, __ATOMIC_RELAXED );
+}
+
+static uint8_t _queuePush(T_lightranger3_svcQueue *q, T_lightranger3_svcSample *sample)
+{
+    uint32_t pos;
+    uint32_t seq;
+    int32_t  diff;
+
+    // A cell is free for position pos when its sequence equals pos
+    pos = __atomic_load_n( &q->enqueuePos, __ATOMIC_RELAXED );
+    for (;;)
+    {
+        seq  = __atomic_load_n( &q->cell[ pos & SVC_QUEUE_MASK ].seq, __ATOMIC_ACQUIRE );
+        diff = (int32_t)(seq - pos);
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n( &q->enqueuePos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return 0;
+        }
+        else
+        {
+            pos = __atomic_load_n( &q->enqueuePos, __ATOMIC_RELAXED );
+        }
+    }
+    q->cell[ pos & SVC_QUEUE_MASK ].data = *sample;
+    __atomic_store_n( &q->cell[ pos & SVC_QUEUE_MASK ].seq, pos + 1, __ATOMIC_RELEASE );
+
+    return 1;
+}
+
+static uint8_t _queuePop(T_lightranger3_svcQueue *q, T_lightranger3_svcSample *sample)
+{
+    uint32_t pos;
+    uint32_t seq;
+    int32_t  diff;
+
+    // A cell holds data for position pos when its sequence equals pos + 1
+    pos = __atomic_load_n( &q->dequeuePos, __ATOMIC_RELAXED );
+    for (;;)
+    {
+        seq  = __atomic_load_n( &q->cell[ pos & SVC_QUEUE_MASK ].seq, __ATOMIC_ACQUIRE );
+        diff = (int32_t)(seq - (pos + 1));
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n( &q->dequeuePos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return 0;
+        }
+        else
+        {
+            pos = __atomic_load_n( &q->dequeuePos, __ATOMIC_RELAXED );
+        }
+    }
+    *sample = q->cell[ pos & SVC_QUEUE_MASK ].data;
+    __atomic_store_n( &q->cell[ pos & SVC_QUEUE_MASK ].seq, pos + _LIGHTRANGER3_SVC_QUEUE_SIZE, __ATOMIC_RELEASE );
+
+    return 1;
+}
+
+static void* _svcWorker(void *arg)
+{
+    T_lightranger3_svcBus    *bus = (T_lightranger3_svcBus*)arg;
+    T_lightranger3_dev       *live[ 255 ];
+    uint8_t                  map[ 255 ];
+    T_lightranger3_sample    smp;
+    T_lightranger3_svcSample out;
+    uint8_t                  nLive = 0;
+    uint8_t                  idle = 0;
+    uint8_t                  idx;
+    uint8_t                  i;
+
+    // Everything below runs on this thread's own HAL and bus state
+    for (i = 0; i < bus->count; i++)
+    {
+        if (lightranger3_devInit( bus->devs[ i ] ) != 0)
+        {
+            bus->initErrors++;
+            continue;
+        }
+        live[ nLive ] = bus->devs[ i ];
+        map[ nLive ]  = i;
+        nLive++;
+    }
+
+    lightranger3_schedInit( &bus->sched, live, nLive );
+    lightranger3_schedStart( &bus->sched );
+
+    while (nLive != 0 && __atomic_load_n( bus->running, __ATOMIC_ACQUIRE )
+           && (bus->limit == 0 || bus->published + bus->dropped < bus->limit))
+    {
+        idx = lightranger3_schedService( &bus->sched, &smp );
+        if (idx == 0xFF)
+        {
+            // Whole round without a result, let the sensors integrate
+            if (++idle >= nLive)
+            {
+                Delay_10us();
+                idle = 0;
+            }
+            continue;
+        }
+        idle = 0;
+
+        out.sample    = smp;
+        out.bus       = bus->index;
+        out.sensor    = map[ idx ];
+        out.publishNs = lightranger3_svcNowNs();
+        if (bus->shm != 0)
+        {
+            lightranger3_shmPublish( bus->shm, &smp, bus->index, out.sensor );
+        }
+        if (_queuePush( &bus->queue, &out ))
+        {
+            bus->published++;
+        }
+        else
+        {
+            bus->dropped++;
+        }
+    }
+    lightranger3_schedStop( &bus->sched );
+    __atomic_store_n( &bus->done, 1, __ATOMIC_RELEASE );
+
+    return 0;
+}
+
+/* --------------------------------------------------------- PUBLIC FUNCTIONS */
+
+void lightranger3_svcInit(T_lightranger3_svc *svc)
+{
+    svc->busCount = 0;
+    __atomic_store_n( &svc->running, 0, __ATOMIC_RELEASE );
+}
+
+uint8_t lightranger3_svcAddBus(T_lightranger3_svc *svc, T_lightranger3_dev **devs, uint8_t count, uint32_t limit)
+{
+    T_lightranger3_svcBus *bus;
+
+    if (__atomic_load_n( &svc->running, __ATOMIC_ACQUIRE ) || svc->busCount == _LIGHTRANGER3_SVC_MAX_BUSES)
+    {
+        return 0xFF;
+    }
+    bus = &svc->bus[ svc->busCount ];
+    bus->devs       = devs;
+    bus->count      = count;
+    bus->index      = svc->busCount;
+    bus->limit      = limit;
+    bus->running    = &svc->running;
+    bus->published  = 0;
+    bus->dropped    = 0;
+    bus->initErrors = 0;
+    bus->done       = 0;
+    bus->shm        = 0;
+    _queueInit( &bus->queue );
+
+    return svc->busCount++;
+}
+
+uint8_t lightranger3_svcAttachShm(T_lightranger3_svc *svc, uint8_t bus, T_lightranger3_shmWriter *shm)
+{
+    if (__atomic_load_n( &svc->running, __ATOMIC_ACQUIRE ) || bus >= svc->busCount)
+    {
+        return 1;
+    }
+    svc->bus[ bus ].shm = shm;
+
+    return 0;
+}
+
+uint8_t lightranger3_svcStart(T_lightranger3_svc *svc)
+{
+    uint8_t i;
+
+    __atomic_store_n( &svc->running, 1, __ATOMIC_RELEASE );
+    for (i = 0; i < svc->busCount; i++)
+    {
+        if (pthread_create( &svc->bus[ i ].thread, 0, _svcWorker, &svc->bus[ i ] ) != 0)
+        {
+            svc->busCount = i;
+            lightranger3_svcStop( svc );
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void lightranger3_svcStop(T_lightranger3_svc *svc)
+{
+    uint8_t i;
+
+    __atomic_store_n( &svc->running, 0, __ATOMIC_RELEASE );
+    for (i = 0; i < svc->busCount; i++)
+    {
+        pthread_join( svc->bus[ i ].thread, 0 );
+    }
+}
+
+uint8_t lightranger3_svcPop(T_lightranger3_svc *svc, uint8_t bus, T_lightranger3_svcSample *sample)
+{
+    if (bus >= svc->busCount)
+    {
+        return 0;
+    }
+    return _queuePop( &svc->bus[ bus ].queue, sample );
+}
+
+uint8_t lightranger3_svcPopAny(T_lightranger3_svc *svc, uint8_t *cursor, T_lightranger3_svcSample *sample)
+{
+    uint8_t i;
+    uint8_t bus;
+
+    for (i = 0; i < svc->busCount; i++)
+    {
+        bus = (*cursor + i) % svc->busCount;
+        if (_queuePop( &svc->bus[ bus ].queue, sample ))
+        {
+            *cursor = bus + 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint8_t lightranger3_svcDone(T_lightranger3_svc *svc)
+{
+    uint8_t i;
+
+    for (i = 0; i < svc->busCount; i++)
+    {
+        if (__atomic_load_n( &svc->bus[ i ].done, __ATOMIC_ACQUIRE ) == 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+uint64_t lightranger3_svcNowNs()
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+  __lightranger3_service.c
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */
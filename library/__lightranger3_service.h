@@ -0,0 +1,261 @@
+/*
+    __lightranger3_service.h
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+/**
+@file   __lightranger3_service.h
+@brief    LightRanger_3 Linux Acquisition Service
+*/
+/**
+@defgroup   LIGHTRANGER3_SERVICE
+@brief      Thread per bus acquisition service for Linux hosts
+@{
+
+Runs one worker thread per I2C bus. Each worker initializes the sensors of
+its bus and keeps them measuring with the multi-sensor scheduler
+(lightranger3_schedService). Samples are published to a bounded lock-free
+queue owned by the worker, so workers never contend with each other.
+
+Any number of consumer threads may pop from any queue: the queues are
+multi-producer multi-consumer (per cell sequence numbers), with one
+producer per queue the push side never retries. There is no lock anywhere
+on the sample path; the driver and HAL keep their bus state per thread
+(__HAL_THREAD__), so the workers do not share mutable driver state.
+
+Build with the driver and -lpthread:
+
+    gcc -O2 -I library app.c library/__lightranger3_service.c \
+        library/__lightranger3_shm.c library/__lightranger3_driver.c -lpthread
+
+*/
+/* -------------------------------------------------------------------------- */
+
+#include "stdint.h"
+#include <pthread.h>
+
+#include "__lightranger3_driver.h"
+#include "__lightranger3_shm.h"
+
+#ifndef _LIGHTRANGER3_SERVICE_H_
+#define _LIGHTRANGER3_SERVICE_H_
+
+/** @defgroup LIGHTRANGER3_SERVICE_VAR Variables */                   /** @{ */
+
+#ifndef   _LIGHTRANGER3_SVC_MAX_BUSES
+  #define   _LIGHTRANGER3_SVC_MAX_BUSES     8                      /**<     @macro _LIGHTRANGER3_SVC_MAX_BUSES @brief Worker threads per service */
+#endif
+#ifndef   _LIGHTRANGER3_SVC_QUEUE_SIZE
+  #define   _LIGHTRANGER3_SVC_QUEUE_SIZE    1024                   /**<     @macro _LIGHTRANGER3_SVC_QUEUE_SIZE @brief Samples per bus queue, power of two */
+#endif
+
+                                                                       /** @} */
+/** @defgroup LIGHTRANGER3_SERVICE_TYPES Types */                     /** @{ */
+
+/**
+ * @brief Published sample
+ */
+typedef struct
+{
+    T_lightranger3_sample   sample;
+    uint8_t                 bus;            /**< Index returned by lightranger3_svcAddBus */
+    uint8_t                 sensor;         /**< Index in the sensor list of the bus */
+    uint64_t                publishNs;      /**< CLOCK_MONOTONIC at push */
+
+}T_lightranger3_svcSample;
+
+/**
+ * @brief Bounded lock-free sample queue
+ */
+typedef struct
+{
+    struct
+    {
+        uint32_t                    seq;
+        T_lightranger3_svcSample    data;
+
+    }cell[ _LIGHTRANGER3_SVC_QUEUE_SIZE ];
+
+    uint32_t    enqueuePos __attribute__(( aligned( 64 ) ));
+    uint32_t    dequeuePos __attribute__(( aligned( 64 ) ));
+
+}T_lightranger3_svcQueue;
+
+/**
+ * @brief One bus and its worker
+ */
+typedef struct
+{
+    T_lightranger3_dev      **devs;
+    uint8_t                 count;
+    uint8_t                 index;
+    uint32_t                limit;
+    uint8_t                 *running;       /**< Service stop flag, accessed atomically */
+
+    T_lightranger3_sched    sched;
+    pthread_t               thread;
+    T_lightranger3_shmWriter *shm;
+
+    uint32_t                published;
+    uint32_t                dropped;
+    uint32_t                initErrors;
+    uint8_t                 done;
+
+    T_lightranger3_svcQueue queue;
+
+}T_lightranger3_svcBus;
+
+/**
+ * @brief Acquisition service
+ */
+typedef struct
+{
+    T_lightranger3_svcBus   bus[ _LIGHTRANGER3_SVC_MAX_BUSES ];
+    uint8_t                 busCount;
+    uint8_t                 running;        /**< Accessed with __atomic builtins, workers stop on 0 */
+
+}T_lightranger3_svc;
+
+                                                                       /** @} */
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** @defgroup LIGHTRANGER3_SERVICE_FUNC Service Functions */          /** @{ */
+
+/**
+ * @brief Initializes empty service
+ */
+void lightranger3_svcInit(T_lightranger3_svc *svc);
+
+/**
+ * @brief Adds bus with its sensors
+ *
+ * @param[in] svc     Service
+ * @param[in] devs    Instances bound with lightranger3_devI2cInit, all to
+ *                    the same I2C object
+ * @param[in] count   Number of instances
+ * @param[in] limit   Samples to publish before the worker stops, 0 for no
+ *                    limit
+ *
+ * @retval bus index, 0xFF if the service is full or running
+ *
+ * The worker runs lightranger3_devInit on every sensor before it starts
+ * scheduling, sensors that fail init are counted in initErrors and skipped.
+ */
+uint8_t lightranger3_svcAddBus(T_lightranger3_svc *svc, T_lightranger3_dev **devs, uint8_t count, uint32_t limit);
+
+/**
+ * @brief Mirrors the samples of one bus into a shared memory ring
+ *
+ * @param[in] svc   Service
+ * @param[in] bus   Bus index
+ * @param[in] shm   Ring created with lightranger3_shmCreate, owned by this
+ *                  bus alone since the ring takes a single writer
+ *
+ * @retval 0 on success, 1 if the bus is unknown or the service is running
+ *
+ * The worker publishes every sample to the ring, including those dropped
+ * by a full queue, so reader processes see the whole stream.
+ */
+uint8_t lightranger3_svcAttachShm(T_lightranger3_svc *svc, uint8_t bus, T_lightranger3_shmWriter *shm);
+
+/**
+ * @brief Starts one worker thread per bus
+ *
+ * @retval 0 on success, 1 if a thread could not be created
+ */
+uint8_t lightranger3_svcStart(T_lightranger3_svc *svc);
+
+/**
+ * @brief Stops and joins all workers
+ *
+ * Samples already queued stay poppable.
+ */
+void lightranger3_svcStop(T_lightranger3_svc *svc);
+
+/**
+ * @brief Pops oldest sample of one bus
+ *
+ * @retval 1 when a sample was popped, 0 when the queue is empty
+ *
+ * Safe from any number of threads.
+ */
+uint8_t lightranger3_svcPop(T_lightranger3_svc *svc, uint8_t bus, T_lightranger3_svcSample *sample);
+
+/**
+ * @brief Pops a sample from any bus
+ *
+ * @param[in]     svc      Service
+ * @param[in,out] cursor   Consumer owned bus cursor, start at 0; spreads
+ *                         consumers over the queues
+ * @param[out]    sample   Popped sample
+ *
+ * @retval 1 when a sample was popped, 0 when every queue is empty
+ */
+uint8_t lightranger3_svcPopAny(T_lightranger3_svc *svc, uint8_t *cursor, T_lightranger3_svcSample *sample);
+
+/**
+ * @brief Checks whether every worker has finished
+ *
+ * @retval 1 when all workers reached their limit or were stopped
+ */
+uint8_t lightranger3_svcDone(T_lightranger3_svc *svc);
+
+/**
+ * @brief Monotonic time in nanoseconds, the clock of publishNs
+ */
+uint64_t lightranger3_svcNowNs();
+
+                                                                       /** @} */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif
+                                                                       /** @} */
+/* -------------------------------------------------------------------------- */
+/*
+  __lightranger3_service.h
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */
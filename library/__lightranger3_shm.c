@@ -0,0 +1,270 @@
+/*
+    __lightranger3_shm.c
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "__lightranger3_shm.h"
+
+/* -------------------------------------------- PRIVATE FUNCTION DECLARATIONS */
+
+static uint32_t _shmSize(uint32_t capacity);
+static uint64_t _shmNowNs();
+
+/* --------------------------------------------- PRIVATE FUNCTION DEFINITIONS */
+
+static uint32_t _shmSize(uint32_t capacity)
+{
+    return sizeof( T_lightranger3_shmHeader ) + capacity * sizeof( T_lightranger3_shmRecord );
+}
+
+static uint64_t _shmNowNs()
+{
+    struct timespec ts;
+
+    // vDSO on Linux, no kernel entry
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* --------------------------------------------------------- PUBLIC FUNCTIONS */
+
+uint8_t lightranger3_shmCreate(T_lightranger3_shmWriter *w, const char *name, uint32_t capacity)
+{
+    uint32_t cap = 2;
+    int      fd;
+    void     *map;
+
+    while (cap < capacity)
+    {
+        cap <<= 1;
+    }
+    if (strlen( name ) >= sizeof( w->name ))
+    {
+        return 1;
+    }
+
+    shm_unlink( name );
+    fd = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0644 );
+    if (fd < 0)
+    {
+        return 1;
+    }
+    if (ftruncate( fd, _shmSize( cap ) ) != 0)
+    {
+        close( fd );
+        shm_unlink( name );
+        return 1;
+    }
+    map = mmap( 0, _shmSize( cap ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+    if (map == MAP_FAILED)
+    {
+        shm_unlink( name );
+        return 1;
+    }
+
+    // ftruncate zero fills, so every record starts out unwritten (seq 0)
+    w->hdr  = (T_lightranger3_shmHeader*)map;
+    w->size = _shmSize( cap );
+    w->mask = cap - 1;
+    w->pos  = 0;
+    strcpy( w->name, name );
+
+    w->hdr->version    = _LIGHTRANGER3_SHM_VERSION;
+    w->hdr->recordSize = sizeof( T_lightranger3_shmRecord );
+    w->hdr->capacity   = cap;
+    w->hdr->closed     = 0;
+    __atomic_store_n( &w->hdr->writePos, 0, __ATOMIC_RELAXED );
+    // Magic last, readers reject the object until the header is complete
+    __atomic_store_n( &w->hdr->magic, _LIGHTRANGER3_SHM_MAGIC, __ATOMIC_RELEASE );
+
+    return 0;
+}
+
+void lightranger3_shmPublish(T_lightranger3_shmWriter *w, T_lightranger3_sample *sample, uint8_t bus, uint8_t sensor)
+{
+    T_lightranger3_shmRecord *rec = &w->hdr->rec[ w->pos & w->mask ];
+
+    // Invalidate before touching the payload so a reader copying it sees the change
+    __atomic_store_n( &rec->seq, 0, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+
+    rec->distance        = sample->distance;
+    rec->confidenceValue = sample->confidenceValue;
+    rec->errorCode       = sample->errorCode;
+    rec->bus             = bus;
+    rec->sensor          = sensor;
+    rec->reserved        = 0;
+    rec->timestamp       = sample->timestamp;
+    rec->timestampNs     = _shmNowNs();
+
+    w->pos++;
+    __atomic_store_n( &rec->seq, (uint32_t)w->pos, __ATOMIC_RELEASE );
+    __atomic_store_n( &w->hdr->writePos, w->pos, __ATOMIC_RELEASE );
+}
+
+void lightranger3_shmDestroy(T_lightranger3_shmWriter *w)
+{
+    __atomic_store_n( &w->hdr->closed, 1, __ATOMIC_RELEASE );
+    munmap( w->hdr, w->size );
+    shm_unlink( w->name );
+    w->hdr = 0;
+}
+
+uint8_t lightranger3_shmOpen(T_lightranger3_shmReader *r, const char *name)
+{
+    const T_lightranger3_shmHeader *hdr;
+    struct stat st;
+    int         fd;
+    void        *map;
+
+    fd = shm_open( name, O_RDONLY, 0 );
+    if (fd < 0)
+    {
+        return 1;
+    }
+    if (fstat( fd, &st ) != 0 || st.st_size < (off_t)sizeof( T_lightranger3_shmHeader ))
+    {
+        close( fd );
+        return 1;
+    }
+    map = mmap( 0, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+    if (map == MAP_FAILED)
+    {
+        return 1;
+    }
+
+    hdr = (const T_lightranger3_shmHeader*)map;
+    if (__atomic_load_n( &hdr->magic, __ATOMIC_ACQUIRE ) != _LIGHTRANGER3_SHM_MAGIC
+        || hdr->version != _LIGHTRANGER3_SHM_VERSION
+        || hdr->recordSize != sizeof( T_lightranger3_shmRecord )
+        || (hdr->capacity & (hdr->capacity - 1)) != 0
+        || _shmSize( hdr->capacity ) != st.st_size)
+    {
+        munmap( map, st.st_size );
+        return 1;
+    }
+
+    r->hdr      = hdr;
+    r->size     = st.st_size;
+    r->mask     = hdr->capacity - 1;
+    r->next     = __atomic_load_n( &hdr->writePos, __ATOMIC_ACQUIRE );
+    r->read     = 0;
+    r->lost     = 0;
+    r->overruns = 0;
+
+    return 0;
+}
+
+uint8_t lightranger3_shmRead(T_lightranger3_shmReader *r, T_lightranger3_shmRecord *rec)
+{
+    const T_lightranger3_shmRecord *slot;
+    uint64_t wp;
+    uint64_t resume;
+    uint32_t seq;
+
+    wp = __atomic_load_n( &r->hdr->writePos, __ATOMIC_ACQUIRE );
+    if (r->next == wp)
+    {
+        return _LIGHTRANGER3_SHM_EMPTY;
+    }
+
+    if (wp - r->next <= r->mask + 1)
+    {
+        slot = &r->hdr->rec[ r->next & r->mask ];
+        seq  = __atomic_load_n( &slot->seq, __ATOMIC_ACQUIRE );
+        if (seq == (uint32_t)(r->next + 1))
+        {
+            *rec = *slot;
+            __atomic_thread_fence( __ATOMIC_ACQUIRE );
+            if (__atomic_load_n( &slot->seq, __ATOMIC_RELAXED ) == seq)
+            {
+                rec->seq = seq;
+                r->next++;
+                r->read++;
+                return _LIGHTRANGER3_SHM_OK;
+            }
+        }
+        // Record is being rewritten, the writer lapped us while we looked
+        wp = __atomic_load_n( &r->hdr->writePos, __ATOMIC_ACQUIRE );
+    }
+
+    // Half a ring of headroom so a steady writer does not lap us again at once
+    resume = wp - ((r->mask + 1) >> 1);
+    r->lost += resume - r->next;
+    r->next  = resume;
+    r->overruns++;
+
+    return _LIGHTRANGER3_SHM_OVERRUN;
+}
+
+uint64_t lightranger3_shmLag(T_lightranger3_shmReader *r)
+{
+    return __atomic_load_n( &r->hdr->writePos, __ATOMIC_ACQUIRE ) - r->next;
+}
+
+uint8_t lightranger3_shmClosed(T_lightranger3_shmReader *r)
+{
+    return __atomic_load_n( &r->hdr->closed, __ATOMIC_ACQUIRE ) != 0;
+}
+
+void lightranger3_shmClose(T_lightranger3_shmReader *r)
+{
+    munmap( (void*)r->hdr, r->size );
+    r->hdr = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+  __lightranger3_shm.c
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */
@@ -0,0 +1,249 @@
+/*
+    __lightranger3_shm.h
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+/**
+@file   __lightranger3_shm.h
+@brief    LightRanger_3 Shared Memory Sample Stream
+*/
+/**
+@defgroup   LIGHTRANGER3_SHM
+@brief      Memory mapped sample ring for host reader processes
+@{
+
+One writer publishes samples into a POSIX shared memory object laid out as
+a header followed by a fixed array of records. Any number of reader
+processes map the object read only and follow the writer on their own;
+readers never write to the mapping and no system call is made per sample
+on either side.
+
+Every record carries its own sequence number (seqlock): the writer clears
+it, fills the record and then stores the record position. A reader that
+sees the expected sequence before and after copying a record has a
+consistent copy, otherwise the writer has lapped it. Each reader keeps its
+own position, so lag (lightranger3_shmLag) and overruns are detected per
+reader and a slow reader never holds back the writer or the other readers.
+
+Linux only, link with -lrt on C libraries older than glibc 2.17.
+
+*/
+/* -------------------------------------------------------------------------- */
+
+#include "stdint.h"
+
+#include "__lightranger3_driver.h"
+
+#ifndef _LIGHTRANGER3_SHM_H_
+#define _LIGHTRANGER3_SHM_H_
+
+/** @defgroup LIGHTRANGER3_SHM_VAR Variables */                       /** @{ */
+
+#define _LIGHTRANGER3_SHM_MAGIC         0x4C523353                 /**<     @macro _LIGHTRANGER3_SHM_MAGIC @brief "LR3S" */
+#define _LIGHTRANGER3_SHM_VERSION       1
+
+// lightranger3_shmRead return values
+#define _LIGHTRANGER3_SHM_OK            0
+#define _LIGHTRANGER3_SHM_EMPTY         1
+#define _LIGHTRANGER3_SHM_OVERRUN       2
+
+                                                                       /** @} */
+/** @defgroup LIGHTRANGER3_SHM_TYPES Types */                         /** @{ */
+
+/**
+ * @brief Shared record, 24 bytes
+ */
+typedef struct
+{
+    uint32_t    seq;                /**< Position + 1, 0 while being written */
+    uint16_t    distance;
+    uint16_t    confidenceValue;
+    uint8_t     errorCode;
+    uint8_t     bus;
+    uint8_t     sensor;
+    uint8_t     reserved;
+    uint32_t    timestamp;          /**< Driver tick of the sample */
+    uint64_t    timestampNs;        /**< CLOCK_MONOTONIC at publish */
+
+}T_lightranger3_shmRecord;
+
+/**
+ * @brief Shared object header, followed by the record array
+ */
+typedef struct
+{
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    recordSize;
+    uint32_t    capacity;           /**< Records, power of two */
+    uint32_t    closed;             /**< Set when the writer goes away */
+
+    uint64_t    writePos __attribute__(( aligned( 64 ) ));
+
+    T_lightranger3_shmRecord rec[] __attribute__(( aligned( 64 ) ));
+
+}T_lightranger3_shmHeader;
+
+/**
+ * @brief Writer side
+ */
+typedef struct
+{
+    T_lightranger3_shmHeader    *hdr;
+    uint32_t                    size;
+    uint32_t                    mask;
+    uint64_t                    pos;
+    char                        name[ 64 ];
+
+}T_lightranger3_shmWriter;
+
+/**
+ * @brief Reader side, one per reader
+ */
+typedef struct
+{
+    const T_lightranger3_shmHeader  *hdr;
+    uint32_t                        size;
+    uint32_t                        mask;
+    uint64_t                        next;       /**< Position of the next record to read */
+    uint64_t                        read;       /**< Records read */
+    uint64_t                        lost;       /**< Records overwritten before they were read */
+    uint32_t                        overruns;   /**< Times this reader was lapped */
+
+}T_lightranger3_shmReader;
+
+                                                                       /** @} */
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** @defgroup LIGHTRANGER3_SHM_FUNC Shared Memory Functions */        /** @{ */
+
+/**
+ * @brief Creates shared ring
+ *
+ * @param[out] w          Writer
+ * @param[in]  name       Shared memory object name, e.g. "/lightranger3"
+ * @param[in]  capacity   Records, rounded up to a power of two
+ *
+ * @retval 0 on success, 1 on error
+ *
+ * An existing object of the same name is replaced.
+ */
+uint8_t lightranger3_shmCreate(T_lightranger3_shmWriter *w, const char *name, uint32_t capacity);
+
+/**
+ * @brief Publishes one sample
+ *
+ * @param[in] w         Writer
+ * @param[in] sample    Sample as produced by the driver
+ * @param[in] bus       Bus index copied to the record
+ * @param[in] sensor    Sensor index copied to the record
+ *
+ * Single writer only. Never blocks, the oldest record is overwritten.
+ */
+void lightranger3_shmPublish(T_lightranger3_shmWriter *w, T_lightranger3_sample *sample, uint8_t bus, uint8_t sensor);
+
+/**
+ * @brief Marks the ring closed and removes the object name
+ *
+ * Readers that already mapped the ring keep their mapping, drain it and
+ * then see lightranger3_shmClosed.
+ */
+void lightranger3_shmDestroy(T_lightranger3_shmWriter *w);
+
+/**
+ * @brief Maps shared ring read only
+ *
+ * @param[out] r      Reader
+ * @param[in]  name   Object name given to lightranger3_shmCreate
+ *
+ * @retval 0 on success, 1 if the object is missing or not a sample ring
+ *
+ * The reader starts at the current write position, records published
+ * before the call are not seen.
+ */
+uint8_t lightranger3_shmOpen(T_lightranger3_shmReader *r, const char *name);
+
+/**
+ * @brief Reads next record
+ *
+ * @param[in]  r     Reader
+ * @param[out] rec   Record copy
+ *
+ * @retval _LIGHTRANGER3_SHM_OK       record copied
+ * @retval _LIGHTRANGER3_SHM_EMPTY    reader is up to date
+ * @retval _LIGHTRANGER3_SHM_OVERRUN  writer lapped the reader, nothing was
+ *                                    copied; the reader skipped ahead to half
+ *                                    a ring behind the writer and added the
+ *                                    skipped records to lost
+ */
+uint8_t lightranger3_shmRead(T_lightranger3_shmReader *r, T_lightranger3_shmRecord *rec);
+
+/**
+ * @brief Records published but not yet read by this reader
+ */
+uint64_t lightranger3_shmLag(T_lightranger3_shmReader *r);
+
+/**
+ * @brief Checks whether the writer destroyed the ring
+ */
+uint8_t lightranger3_shmClosed(T_lightranger3_shmReader *r);
+
+/**
+ * @brief Unmaps reader
+ */
+void lightranger3_shmClose(T_lightranger3_shmReader *r);
+
+                                                                       /** @} */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif
+                                                                       /** @} */
+/* -------------------------------------------------------------------------- */
+/*
+  __lightranger3_shm.h
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */
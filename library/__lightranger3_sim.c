@@ -0,0 +1,786 @@
+/*
+    __lightranger3_sim.c
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+#include "__lightranger3_sim.h"
+
+/* ------------------------------------------------------------------- MACROS */
+
+#define SIM_MEM_SIZE        0x30
+
+#define SIM_REG_ICSR        0x00
+#define SIM_REG_IER         0x02
+#define SIM_REG_CMD         0x04
+#define SIM_REG_DEV_STATUS  0x06
+#define SIM_REG_RESULT      0x08
+#define SIM_REG_RESULT_CFG  0x0A
+#define SIM_REG_CMD_CFG_A   0x0C
+#define SIM_REG_CMD_CFG_B   0x0E
+#define SIM_REG_I2C_INIT    0x1C
+#define SIM_REG_DEVICE_ID   0x28
+
+// DEV_STATUS[4:0] MCPU states
+#define SIM_ST_STANDBY      0x00
+#define SIM_ST_OFF          0x10
+#define SIM_ST_ON           0x18
+
+#define SIM_CMD_NONE        0x00
+#define SIM_CMD_RESET       0x40
+#define SIM_CMD_MEASURE     0x81
+#define SIM_CMD_STANDBY     0x90
+#define SIM_CMD_OFF         0x91
+#define SIM_CMD_ON          0x92
+
+#define SIM_ICSR_DATA_READY 0x10
+
+/* ---------------------------------------------------------------- VARIABLES */
+
+typedef struct
+{
+    const char  *name;
+    uint64_t    now;
+    uint32_t    hz;
+    uint8_t     realtime;
+    uint64_t    paceNs;         /**< Wall clock at virtual time 0 */
+    T_lightranger3_simTraceFp trace;
+
+}T_simBus;
+
+typedef struct
+{
+    uint8_t     bus;
+    uint8_t     address;
+    uint8_t     defaultAddress;
+    uint8_t     enabled;
+    uint8_t     mem[ SIM_MEM_SIZE ];
+    uint8_t     ptr;
+    uint8_t     mcpu;
+    uint8_t     intPin;
+
+    uint8_t     pendingCmd;
+    uint64_t    pendingDue;
+
+    uint8_t     fault;
+    uint16_t    faultCount;
+
+    uint32_t    latency[ _LIGHTRANGER3_SIM_LAT_COUNT ];
+    uint32_t    current[ _LIGHTRANGER3_SIM_PWR_COUNT ];
+    uint32_t    jitter;
+    const T_lightranger3_simSample *profile;
+    uint16_t    profileLen;
+    uint16_t    profileIdx;
+
+    T_lightranger3_simStats stats;
+
+}T_simDev;
+
+static T_simBus _simBus[ _LIGHTRANGER3_SIM_MAX_BUSES ];
+static uint8_t  _simBusCount = 0;
+static T_simDev _simDev[ _LIGHTRANGER3_SIM_MAX_DEVICES ];
+static uint8_t  _simDevCount = 0;
+// Buses may be driven from one thread each
+static __HAL_THREAD__ uint8_t  _simCurBus = 0;
+static __HAL_THREAD__ uint32_t _simSeed = 1;
+
+static const T_lightranger3_simSample _simDefaultSample = { 500, 1000, 0 };
+
+/* --------------------------------------------- PRIVATE FUNCTION DEFINITIONS */
+
+static uint8_t _simBusIndex(const char *name)
+{
+    uint8_t i;
+
+    for (i = 0; i < _simBusCount; i++)
+    {
+        if (strcmp( _simBus[ i ].name, name ) == 0)
+        {
+            return i;
+        }
+    }
+    if (_simBusCount == _LIGHTRANGER3_SIM_MAX_BUSES)
+    {
+        return 0xFF;
+    }
+    _simBus[ _simBusCount ].name = name;
+    _simBus[ _simBusCount ].now  = 0;
+    _simBus[ _simBusCount ].hz   = 100000;
+    _simBus[ _simBusCount ].realtime = 0;
+    _simBus[ _simBusCount ].trace    = 0;
+
+    return _simBusCount++;
+}
+
+static void _simPowerOn(T_simDev *d)
+{
+    memset( d->mem, 0, SIM_MEM_SIZE );
+    d->mem[ SIM_REG_DEVICE_ID ]     = 0x02;
+    d->mem[ SIM_REG_DEVICE_ID + 1 ] = 0xAD;
+    d->address    = d->defaultAddress;
+    d->mcpu       = SIM_ST_STANDBY;
+    d->intPin     = 0;
+    d->ptr        = 0;
+    d->pendingCmd = SIM_CMD_NONE;
+    d->fault      = _LIGHTRANGER3_SIM_FAULT_NONE;
+}
+
+static void _simComplete(T_simDev *d)
+{
+    const T_lightranger3_simSample *smp;
+    uint16_t result;
+    uint16_t config;
+
+    switch (d->pendingCmd)
+    {
+        case SIM_CMD_STANDBY : d->mcpu = SIM_ST_STANDBY; break;
+        case SIM_CMD_OFF     : d->mcpu = SIM_ST_OFF;     break;
+        case SIM_CMD_ON      : d->mcpu = SIM_ST_ON;      break;
+        case SIM_CMD_RESET   : _simPowerOn( d ); d->stats.resets++; break;
+        case SIM_CMD_MEASURE :
+            smp = &_simDefaultSample;
+            if (d->profileLen != 0)
+            {
+                smp = &d->profile[ d->profileIdx ];
+                d->profileIdx = (d->profileIdx + 1) % d->profileLen;
+            }
+            // RESULT: [14:13] error code, [12:2] distance, [0] valid
+            result = ((uint16_t)(smp->errorCode & 0x03) << 13) | ((smp->distance & 0x07FF) << 2) | 0x0001;
+            if (d->fault == _LIGHTRANGER3_SIM_FAULT_ERROR_CODE)
+            {
+                result |= (uint16_t)0x03 << 13;
+                if (--d->faultCount == 0)
+                {
+                    d->fault = _LIGHTRANGER3_SIM_FAULT_NONE;
+                }
+            }
+            // RESULT_CONFIG: [14:4] confidence
+            config = (smp->confidenceValue & 0x07FF) << 4;
+            d->mem[ SIM_REG_RESULT ]         = result & 0xFF;
+            d->mem[ SIM_REG_RESULT + 1 ]     = result >> 8;
+            d->mem[ SIM_REG_RESULT_CFG ]     = config & 0xFF;
+            d->mem[ SIM_REG_RESULT_CFG + 1 ] = config >> 8;
+            d->mem[ SIM_REG_ICSR ] |= SIM_ICSR_DATA_READY;
+            if (d->mem[ SIM_REG_IER ] & 0x01)
+            {
+                d->intPin = 1;
+            }
+            d->stats.measurements++;
+            break;
+    }
+    d->pendingCmd = SIM_CMD_NONE;
+}
+
+static uint8_t _simPowerState(T_simDev *d)
+{
+    if (d->pendingCmd == SIM_CMD_MEASURE)
+    {
+        return _LIGHTRANGER3_SIM_PWR_MEASUREMENT;
+    }
+    if (d->pendingCmd != SIM_CMD_NONE || d->mcpu == SIM_ST_ON)
+    {
+        return _LIGHTRANGER3_SIM_PWR_ON;
+    }
+    if (d->mcpu == SIM_ST_OFF)
+    {
+        return _LIGHTRANGER3_SIM_PWR_OFF;
+    }
+    return _LIGHTRANGER3_SIM_PWR_STANDBY;
+}
+
+static void _simAccount(T_simDev *d, uint64_t us)
+{
+    uint8_t pwr;
+
+    if (!d->enabled || us == 0)
+    {
+        return;
+    }
+    pwr = _simPowerState( d );
+    d->stats.stateUs[ pwr ] += us;
+    d->stats.chargePc       += us * d->current[ pwr ];
+}
+
+static void _simUpdate(T_simDev *d)
+{
+    if (d->pendingCmd != SIM_CMD_NONE && _simBus[ d->bus ].now >= d->pendingDue)
+    {
+        _simComplete( d );
+    }
+}
+
+static uint32_t _simMeasureUs(T_simDev *d)
+{
+    uint32_t peak;
+    uint32_t freq;
+
+    // Unconfigured sensor, plain latency
+    if (d->mem[ SIM_REG_CMD_CFG_A ] == 0 && d->mem[ SIM_REG_CMD_CFG_A + 1 ] == 0)
+    {
+        return d->latency[ _LIGHTRANGER3_SIM_LAT_MEASUREMENT ];
+    }
+    // Integration grows with CMD_CONFIG_A[15:12] and shrinks with
+    // CMD_CONFIG_B[15:12], the init defaults (14, 1) give the plain latency
+    peak = (d->mem[ SIM_REG_CMD_CFG_A + 1 ] >> 4) + 1;
+    freq = (d->mem[ SIM_REG_CMD_CFG_B + 1 ] >> 4) + 1;
+    return (uint32_t)((uint64_t)d->latency[ _LIGHTRANGER3_SIM_LAT_MEASUREMENT ] * peak * 2 / (15 * freq));
+}
+
+static uint8_t _simFaultDrops(T_simDev *d, uint8_t cmd)
+{
+    uint8_t drop = 0;
+
+    switch (d->fault)
+    {
+        case _LIGHTRANGER3_SIM_FAULT_STUCK_MEAS :
+            drop = (cmd == SIM_CMD_MEASURE);
+            break;
+        case _LIGHTRANGER3_SIM_FAULT_STUCK_ON :
+            drop = (cmd == SIM_CMD_MEASURE || cmd == SIM_CMD_ON);
+            break;
+        case _LIGHTRANGER3_SIM_FAULT_HUNG :
+            drop = (cmd != SIM_CMD_RESET);
+            break;
+        default :
+            return 0;
+    }
+    if (drop)
+    {
+        d->stats.ignored++;
+    }
+    else if (d->fault != _LIGHTRANGER3_SIM_FAULT_HUNG)
+    {
+        // Any mode command the fault lets through clears it
+        d->fault = _LIGHTRANGER3_SIM_FAULT_NONE;
+    }
+    return drop;
+}
+
+static void _simCommand(T_simDev *d, uint8_t cmd)
+{
+    uint8_t which;
+
+    d->stats.commands++;
+    if (_simFaultDrops( d, cmd ))
+    {
+        return;
+    }
+    switch (cmd)
+    {
+        case SIM_CMD_STANDBY : which = _LIGHTRANGER3_SIM_LAT_STANDBY;     break;
+        case SIM_CMD_OFF     : which = _LIGHTRANGER3_SIM_LAT_OFF;         break;
+        case SIM_CMD_ON      : which = _LIGHTRANGER3_SIM_LAT_ON;          break;
+        case SIM_CMD_RESET   : which = _LIGHTRANGER3_SIM_LAT_RESET;       break;
+        case SIM_CMD_MEASURE :
+            // Measurements only run with the MCPU on
+            if (d->mcpu != SIM_ST_ON)
+            {
+                return;
+            }
+            which = _LIGHTRANGER3_SIM_LAT_MEASUREMENT;
+            d->mem[ SIM_REG_ICSR ] &= ~SIM_ICSR_DATA_READY;
+            d->intPin = 0;
+            break;
+        default :
+            return;
+    }
+    d->pendingCmd = cmd;
+    d->pendingDue = _simBus[ d->bus ].now + (cmd == SIM_CMD_MEASURE ? _simMeasureUs( d ) : d->latency[ which ]);
+    if (cmd == SIM_CMD_ON && d->mcpu == SIM_ST_STANDBY)
+    {
+        d->pendingDue += d->latency[ _LIGHTRANGER3_SIM_LAT_WAKE ];
+    }
+    if (cmd == SIM_CMD_MEASURE && d->jitter != 0)
+    {
+        _simSeed = _simSeed * 1103515245 + 12345;
+        d->pendingDue += (_simSeed >> 8) % (d->jitter + 1);
+    }
+    _simUpdate( d );
+}
+
+static void _simWrite(T_simDev *d, uint8_t *pBuf, uint16_t nBytes)
+{
+    uint16_t i;
+
+    if (nBytes == 0)
+    {
+        return;
+    }
+    d->ptr = pBuf[ 0 ];
+    for (i = 1; i < nBytes; i++)
+    {
+        if (d->ptr >= SIM_MEM_SIZE)
+        {
+            break;
+        }
+        if (d->ptr == SIM_REG_CMD)
+        {
+            _simCommand( d, pBuf[ i ] );
+        }
+        else if (d->ptr != SIM_REG_DEV_STATUS && d->ptr != SIM_REG_DEVICE_ID && d->ptr != SIM_REG_DEVICE_ID + 1)
+        {
+            d->mem[ d->ptr ] = pBuf[ i ];
+        }
+        d->ptr++;
+    }
+    // I2C_INIT_CFG[15:9] moves the device, 0 selects the power up address
+    if (pBuf[ 0 ] <= SIM_REG_I2C_INIT + 1 && d->ptr > SIM_REG_I2C_INIT + 1)
+    {
+        d->address = d->mem[ SIM_REG_I2C_INIT + 1 ] >> 1;
+        if (d->address == 0)
+        {
+            d->address = d->defaultAddress;
+        }
+    }
+}
+
+static void _simRead(T_simDev *d, uint8_t *pBuf, uint16_t nBytes)
+{
+    uint16_t i;
+
+    for (i = 0; i < nBytes; i++)
+    {
+        if (d->ptr == SIM_REG_DEV_STATUS)
+        {
+            d->mem[ d->ptr ] = (d->mem[ d->ptr ] & 0xE0) | d->mcpu;
+        }
+        pBuf[ i ] = (d->ptr < SIM_MEM_SIZE) ? d->mem[ d->ptr ] : 0xFF;
+        if (d->ptr == SIM_REG_RESULT + 1)
+        {
+            // ICSR = 0x05: data ready and INT are cleared by reading the result
+            d->mem[ SIM_REG_ICSR ] &= ~SIM_ICSR_DATA_READY;
+            d->intPin = 0;
+        }
+        d->ptr++;
+    }
+}
+
+static T_simDev* _simFind(uint8_t bus, uint8_t address)
+{
+    uint8_t i;
+
+    for (i = 0; i < _simDevCount; i++)
+    {
+        if (_simDev[ i ].bus == bus && _simDev[ i ].address == address && _simDev[ i ].enabled)
+        {
+            return &_simDev[ i ];
+        }
+    }
+    return 0;
+}
+
+static uint64_t _simWallNs()
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void _simPace(uint8_t bus)
+{
+    struct timespec ts;
+    uint64_t virtNs;
+    uint64_t wallNs;
+
+    // Sleep only once the virtual clock is 100 us ahead, short waits cost more than they save
+    virtNs = _simBus[ bus ].now * 1000ULL;
+    wallNs = _simWallNs() - _simBus[ bus ].paceNs;
+    if (virtNs > wallNs + 100000ULL)
+    {
+        ts.tv_sec  = (virtNs - wallNs) / 1000000000ULL;
+        ts.tv_nsec = (long)((virtNs - wallNs) % 1000000000ULL);
+        nanosleep( &ts, 0 );
+    }
+}
+
+static void _simAdvance(uint8_t bus, uint64_t us)
+{
+    T_simDev *d;
+    uint64_t now;
+    uint64_t due;
+    uint8_t  i;
+
+    now = _simBus[ bus ].now;
+    for (i = 0; i < _simDevCount; i++)
+    {
+        d = &_simDev[ i ];
+        if (d->bus != bus)
+        {
+            continue;
+        }
+        // Charge the pending state up to its completion, the new one after
+        if (d->pendingCmd != SIM_CMD_NONE && d->pendingDue <= now + us)
+        {
+            due = d->pendingDue > now ? d->pendingDue : now;
+            _simAccount( d, due - now );
+            _simComplete( d );
+            _simAccount( d, now + us - due );
+        }
+        else
+        {
+            _simAccount( d, us );
+        }
+    }
+    _simBus[ bus ].now = now + us;
+    if (_simBus[ bus ].realtime)
+    {
+        _simPace( bus );
+    }
+}
+
+/* ---------------------------------------------------- HAL BACK-END INTERFACE */
+
+static int lightranger3_simOpen(const char *bus)
+{
+    uint8_t idx;
+
+    idx = _simBusIndex( bus );
+    if (idx == 0xFF)
+    {
+        return -1;
+    }
+    _simCurBus = idx;
+
+    return idx;
+}
+
+static void lightranger3_simSleep(uint32_t us)
+{
+    _simAdvance( _simCurBus, us );
+}
+
+static int lightranger3_simTransfer(int bus, struct i2c_msg *msgs, uint8_t nMsgs)
+{
+    T_simDev *d;
+    uint8_t  i;
+    uint32_t bits = 0;
+
+    if (bus < 0 || bus >= _simBusCount)
+    {
+        return -1;
+    }
+    _simCurBus = bus;
+
+    for (i = 0; i < nMsgs; i++)
+    {
+        // START or repeated START, address byte, data bytes, each with ACK
+        bits += 1 + 9 * (1 + msgs[ i ].len);
+        d = _simFind( bus, msgs[ i ].addr );
+        // NACK while absent or rebooting after a reset command
+        if (d == 0 || d->pendingCmd == SIM_CMD_RESET)
+        {
+            if (_simBus[ bus ].trace != 0)
+            {
+                _simBus[ bus ].trace( msgs[ i ].addr, (msgs[ i ].flags & I2C_M_RD) != 0, msgs[ i ].buf, msgs[ i ].len, 1 );
+            }
+            _simAdvance( bus, _simBus[ bus ].hz ? (bits * 1000000ULL) / _simBus[ bus ].hz : 0 );
+            return -1;
+        }
+        if (i == 0)
+        {
+            d->stats.transfers++;
+        }
+        d->stats.bytes += 1 + msgs[ i ].len;
+        if (msgs[ i ].flags & I2C_M_RD)
+        {
+            _simRead( d, msgs[ i ].buf, msgs[ i ].len );
+        }
+        else
+        {
+            _simWrite( d, msgs[ i ].buf, msgs[ i ].len );
+        }
+        if (_simBus[ bus ].trace != 0)
+        {
+            _simBus[ bus ].trace( msgs[ i ].addr, (msgs[ i ].flags & I2C_M_RD) != 0, msgs[ i ].buf, msgs[ i ].len, 0 );
+        }
+    }
+    // STOP
+    bits += 1;
+    _simAdvance( bus, _simBus[ bus ].hz ? (bits * 1000000ULL) / _simBus[ bus ].hz : 0 );
+
+    return 0;
+}
+
+/* ------------------------------------------------------------ GPIO OBJECTS */
+
+#define SIM_INT_GET(n)  static uint8_t _simIntGet##n() { return _simDev[ n ].intPin; }
+
+SIM_INT_GET(0)  SIM_INT_GET(1)  SIM_INT_GET(2)  SIM_INT_GET(3)
+SIM_INT_GET(4)  SIM_INT_GET(5)  SIM_INT_GET(6)  SIM_INT_GET(7)
+SIM_INT_GET(8)  SIM_INT_GET(9)  SIM_INT_GET(10) SIM_INT_GET(11)
+SIM_INT_GET(12) SIM_INT_GET(13) SIM_INT_GET(14) SIM_INT_GET(15)
+SIM_INT_GET(16) SIM_INT_GET(17) SIM_INT_GET(18) SIM_INT_GET(19)
+SIM_INT_GET(20) SIM_INT_GET(21) SIM_INT_GET(22) SIM_INT_GET(23)
+SIM_INT_GET(24) SIM_INT_GET(25) SIM_INT_GET(26) SIM_INT_GET(27)
+SIM_INT_GET(28) SIM_INT_GET(29) SIM_INT_GET(30) SIM_INT_GET(31)
+
+static const T_hal_gpioGetFp _simIntGetFp[ _LIGHTRANGER3_SIM_MAX_DEVICES ] =
+{
+    _simIntGet0,  _simIntGet1,  _simIntGet2,  _simIntGet3,
+    _simIntGet4,  _simIntGet5,  _simIntGet6,  _simIntGet7,
+    _simIntGet8,  _simIntGet9,  _simIntGet10, _simIntGet11,
+    _simIntGet12, _simIntGet13, _simIntGet14, _simIntGet15,
+    _simIntGet16, _simIntGet17, _simIntGet18, _simIntGet19,
+    _simIntGet20, _simIntGet21, _simIntGet22, _simIntGet23,
+    _simIntGet24, _simIntGet25, _simIntGet26, _simIntGet27,
+    _simIntGet28, _simIntGet29, _simIntGet30, _simIntGet31
+};
+
+static T_hal_gpioObj _simGpio[ _LIGHTRANGER3_SIM_MAX_DEVICES ];
+
+/* --------------------------------------------------------- PUBLIC FUNCTIONS */
+
+void lightranger3_simReset()
+{
+    _simBusCount = 0;
+    _simDevCount = 0;
+    _simCurBus   = 0;
+    _simSeed     = 1;
+}
+
+uint8_t lightranger3_simAddDevice(const char *bus, uint8_t address)
+{
+    T_simDev *d;
+    uint8_t  busIdx;
+
+    busIdx = _simBusIndex( bus );
+    if (busIdx == 0xFF || _simDevCount == _LIGHTRANGER3_SIM_MAX_DEVICES)
+    {
+        return 0xFF;
+    }
+    d = &_simDev[ _simDevCount ];
+    memset( d, 0, sizeof( T_simDev ) );
+    d->bus            = busIdx;
+    d->defaultAddress = address;
+    d->enabled        = 1;
+    d->latency[ _LIGHTRANGER3_SIM_LAT_STANDBY ]     = 20;
+    d->latency[ _LIGHTRANGER3_SIM_LAT_OFF ]         = 20;
+    d->latency[ _LIGHTRANGER3_SIM_LAT_ON ]          = 20;
+    d->latency[ _LIGHTRANGER3_SIM_LAT_MEASUREMENT ] = 100;
+    d->latency[ _LIGHTRANGER3_SIM_LAT_RESET ]       = 10000;
+    d->current[ _LIGHTRANGER3_SIM_PWR_STANDBY ]     = 10;
+    d->current[ _LIGHTRANGER3_SIM_PWR_OFF ]         = 500;
+    d->current[ _LIGHTRANGER3_SIM_PWR_ON ]          = 4000;
+    d->current[ _LIGHTRANGER3_SIM_PWR_MEASUREMENT ] = 20000;
+    _simPowerOn( d );
+
+    memset( &_simGpio[ _simDevCount ], 0, sizeof( T_hal_gpioObj ) );
+    _simGpio[ _simDevCount ].gpioGet[ __INT_PIN_INPUT__ ] = _simIntGetFp[ _simDevCount ];
+
+    return _simDevCount++;
+}
+
+void lightranger3_simSetBusSpeed(const char *bus, uint32_t hz)
+{
+    uint8_t busIdx;
+
+    busIdx = _simBusIndex( bus );
+    if (busIdx != 0xFF)
+    {
+        _simBus[ busIdx ].hz = hz;
+    }
+}
+
+void lightranger3_simSetRealtime(const char *bus, uint8_t on)
+{
+    uint8_t busIdx;
+
+    busIdx = _simBusIndex( bus );
+    if (busIdx != 0xFF)
+    {
+        _simBus[ busIdx ].realtime = on;
+        _simBus[ busIdx ].paceNs   = _simWallNs() - _simBus[ busIdx ].now * 1000ULL;
+    }
+}
+
+void lightranger3_simSetTrace(const char *bus, T_lightranger3_simTraceFp traceFp)
+{
+    uint8_t busIdx;
+
+    busIdx = _simBusIndex( bus );
+    if (busIdx != 0xFF)
+    {
+        _simBus[ busIdx ].trace = traceFp;
+    }
+}
+
+uint8_t lightranger3_simI2cTransfer(const char *bus, uint8_t address, uint8_t *wBuf, uint16_t wLen, uint8_t *rBuf, uint16_t rLen)
+{
+    struct i2c_msg msg[ 2 ];
+    uint8_t n = 0;
+    int     busIdx;
+
+    busIdx = lightranger3_simOpen( bus );
+    if (busIdx < 0)
+    {
+        return 1;
+    }
+    if (wLen != 0)
+    {
+        msg[ n ].addr  = address;
+        msg[ n ].flags = 0;
+        msg[ n ].len   = wLen;
+        msg[ n ].buf   = wBuf;
+        n++;
+    }
+    if (rLen != 0)
+    {
+        msg[ n ].addr  = address;
+        msg[ n ].flags = I2C_M_RD;
+        msg[ n ].len   = rLen;
+        msg[ n ].buf   = rBuf;
+        n++;
+    }
+    return lightranger3_simTransfer( busIdx, msg, n ) != 0;
+}
+
+void lightranger3_simSetLatency(uint8_t dev, uint8_t which, uint32_t us)
+{
+    if (dev < _simDevCount && which < _LIGHTRANGER3_SIM_LAT_COUNT)
+    {
+        _simDev[ dev ].latency[ which ] = us;
+    }
+}
+
+void lightranger3_simSetCurrent(uint8_t dev, uint8_t which, uint32_t ua)
+{
+    if (dev < _simDevCount && which < _LIGHTRANGER3_SIM_PWR_COUNT)
+    {
+        _simDev[ dev ].current[ which ] = ua;
+    }
+}
+
+void lightranger3_simSetJitter(uint8_t dev, uint32_t us)
+{
+    if (dev < _simDevCount)
+    {
+        _simDev[ dev ].jitter = us;
+    }
+}
+
+void lightranger3_simInjectFault(uint8_t dev, uint8_t fault, uint16_t count)
+{
+    if (dev < _simDevCount)
+    {
+        _simDev[ dev ].fault      = fault;
+        _simDev[ dev ].faultCount = count ? count : 1;
+    }
+}
+
+void lightranger3_simSetEnable(uint8_t dev, uint8_t state)
+{
+    if (dev < _simDevCount)
+    {
+        if (state && !_simDev[ dev ].enabled)
+        {
+            _simPowerOn( &_simDev[ dev ] );
+        }
+        _simDev[ dev ].enabled = state;
+    }
+}
+
+void lightranger3_simPowerCycle(uint8_t dev)
+{
+    if (dev < _simDevCount)
+    {
+        _simPowerOn( &_simDev[ dev ] );
+    }
+}
+
+void lightranger3_simSetProfile(uint8_t dev, const T_lightranger3_simSample *profile, uint16_t len)
+{
+    if (dev < _simDevCount)
+    {
+        _simDev[ dev ].profile    = profile;
+        _simDev[ dev ].profileLen = len;
+        _simDev[ dev ].profileIdx = 0;
+    }
+}
+
+uint8_t lightranger3_simIntGet(uint8_t dev)
+{
+    if (dev >= _simDevCount)
+    {
+        return 0;
+    }
+    _simUpdate( &_simDev[ dev ] );
+
+    return _simDev[ dev ].intPin;
+}
+
+const uint8_t* lightranger3_simGpioObj(uint8_t dev)
+{
+    return (const uint8_t*)&_simGpio[ dev ];
+}
+
+void lightranger3_simGetStats(uint8_t dev, T_lightranger3_simStats *stats)
+{
+    if (dev < _simDevCount)
+    {
+        *stats = _simDev[ dev ].stats;
+    }
+}
+
+uint64_t lightranger3_simTime(const char *bus)
+{
+    uint8_t busIdx;
+
+    busIdx = _simBusIndex( bus );
+    if (busIdx == 0xFF)
+    {
+        return 0;
+    }
+    return _simBus[ busIdx ].now;
+}
+
+uint32_t lightranger3_simTickUs()
+{
+    return (uint32_t)_simBus[ _simCurBus ].now;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+  __lightranger3_sim.c
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */
@@ -0,0 +1,331 @@
+/*
+    __lightranger3_sim.h
+
+-----------------------------------------------------------------------------
+
+  This file is part of mikroSDK.
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+----------------------------------------------------------------------------- */
+
+/**
+@file   __lightranger3_sim.h
+@brief    LightRanger_3 Simulator
+*/
+/**
+@defgroup   LIGHTRANGER3_SIM
+@brief      RFD77402 register level simulator
+@{
+
+Host side model of the RFD77402 register map, used in place of real hardware
+when the driver is built for Linux with __LIGHTRANGER3_SIM__ defined. The
+Linux HAL back-end then hands every I2C_RDWR transfer to the simulator
+instead of the kernel, and the delay functions advance a virtual clock
+instead of sleeping, so the unmodified driver runs as fast as the host
+allows.
+
+Buses are identified by the device node string of the I2C object, any
+string will do. Each bus keeps its own virtual clock in microseconds which
+is advanced by delays and by the time every transfer would take on the
+wire at the configured bus speed.
+
+*/
+/* -------------------------------------------------------------------------- */
+
+#include "stdint.h"
+
+#ifndef _LIGHTRANGER3_SIM_H_
+#define _LIGHTRANGER3_SIM_H_
+
+/** @defgroup LIGHTRANGER3_SIM_VAR Variables */                       /** @{ */
+
+#define _LIGHTRANGER3_SIM_MAX_BUSES         8
+#define _LIGHTRANGER3_SIM_MAX_DEVICES       32
+
+// Latency selectors for lightranger3_simSetLatency
+#define _LIGHTRANGER3_SIM_LAT_STANDBY       0
+#define _LIGHTRANGER3_SIM_LAT_OFF           1
+#define _LIGHTRANGER3_SIM_LAT_ON            2
+#define _LIGHTRANGER3_SIM_LAT_MEASUREMENT   3
+#define _LIGHTRANGER3_SIM_LAT_RESET         4
+#define _LIGHTRANGER3_SIM_LAT_WAKE          5       /**<     @macro _LIGHTRANGER3_SIM_LAT_WAKE @brief Extra time to reach on from standby */
+#define _LIGHTRANGER3_SIM_LAT_COUNT         6
+
+// Power states for lightranger3_simSetCurrent and T_lightranger3_simStats
+#define _LIGHTRANGER3_SIM_PWR_STANDBY       0
+#define _LIGHTRANGER3_SIM_PWR_OFF           1
+#define _LIGHTRANGER3_SIM_PWR_ON            2       /**<     @macro _LIGHTRANGER3_SIM_PWR_ON @brief MCPU on, also while a mode transition runs */
+#define _LIGHTRANGER3_SIM_PWR_MEASUREMENT   3
+#define _LIGHTRANGER3_SIM_PWR_COUNT         4
+
+// Faults for lightranger3_simInjectFault
+#define _LIGHTRANGER3_SIM_FAULT_NONE        0
+#define _LIGHTRANGER3_SIM_FAULT_ERROR_CODE  1       /**<     @macro _LIGHTRANGER3_SIM_FAULT_ERROR_CODE @brief Next results carry error code 3 */
+#define _LIGHTRANGER3_SIM_FAULT_STUCK_MEAS  2       /**<     @macro _LIGHTRANGER3_SIM_FAULT_STUCK_MEAS @brief Measure ignored until the next mode command */
+#define _LIGHTRANGER3_SIM_FAULT_STUCK_ON    3       /**<     @macro _LIGHTRANGER3_SIM_FAULT_STUCK_ON @brief Measure and on ignored until standby or off */
+#define _LIGHTRANGER3_SIM_FAULT_HUNG        4       /**<     @macro _LIGHTRANGER3_SIM_FAULT_HUNG @brief Every command but reset ignored */
+
+                                                                       /** @} */
+/** @defgroup LIGHTRANGER3_SIM_TYPES Types */                         /** @{ */
+
+/**
+ * @brief Scripted measurement outcome
+ */
+typedef struct
+{
+    uint16_t    distance;
+    uint16_t    confidenceValue;
+    uint8_t     errorCode;
+
+}T_lightranger3_simSample;
+
+/**
+ * @brief Per device traffic and activity counters
+ */
+typedef struct
+{
+    uint32_t    transfers;      /**< START to STOP transactions */
+    uint32_t    bytes;          /**< Bytes on the wire, address bytes included */
+    uint32_t    commands;
+    uint32_t    measurements;
+    uint32_t    resets;
+    uint32_t    ignored;        /**< Commands dropped by an injected fault */
+    uint64_t    stateUs[ _LIGHTRANGER3_SIM_PWR_COUNT ];    /**< Virtual time in each power state */
+    uint64_t    chargePc;       /**< Supply charge in pC (uA x us) */
+
+}T_lightranger3_simStats;
+
+/**
+ * @brief Transfer trace callback
+ *
+ * Called for every message of a transfer in bus order. read is 1 for a
+ * read message, buf holds the bytes written or the bytes returned; nack is
+ * 1 when no device answered the address, the transfer ends there.
+ */
+typedef void (*T_lightranger3_simTraceFp)(uint8_t address, uint8_t read, const uint8_t *buf, uint16_t len, uint8_t nack);
+
+                                                                       /** @} */
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** @defgroup LIGHTRANGER3_SIM_FUNC Simulator Functions */            /** @{ */
+
+/**
+ * @brief Removes all simulated buses and devices
+ */
+void lightranger3_simReset();
+
+/**
+ * @brief Adds simulated sensor
+ *
+ * @param[in] bus       Device node string of the bus
+ * @param[in] address   7 bit slave address
+ *
+ * @retval device index, 0xFF if the device table is full
+ *
+ * The device powers up enabled, in standby, with the default latencies and
+ * currents and reports 500 mm at confidence 1000 until a profile is set. address is its
+ * power up address; writing I2C_INIT_CFG[15:9] moves it elsewhere until the
+ * next power cycle or reset.
+ */
+uint8_t lightranger3_simAddDevice(const char *bus, uint8_t address);
+
+/**
+ * @brief Sets bus speed used for wire time accounting
+ *
+ * @param[in] bus       Device node string of the bus
+ * @param[in] hz        SCL frequency, 0 makes transfers take no time
+ */
+void lightranger3_simSetBusSpeed(const char *bus, uint32_t hz);
+
+/**
+ * @brief Paces the virtual clock of a bus to wall clock time
+ *
+ * @param[in] bus       Device node string of the bus
+ * @param[in] on        1 to pace, 0 to run as fast as the host allows
+ *
+ * While paced, whatever advances the virtual clock sleeps until wall clock
+ * time has caught up with it, so the bus delivers samples at the rate the
+ * real sensors would. Use it where the consumers of the samples, not the
+ * driver, are measured.
+ */
+void lightranger3_simSetRealtime(const char *bus, uint8_t on);
+
+/**
+ * @brief Traces every message on a bus
+ *
+ * @param[in] bus       Device node string of the bus
+ * @param[in] traceFp   Callback, 0 to stop tracing
+ */
+void lightranger3_simSetTrace(const char *bus, T_lightranger3_simTraceFp traceFp);
+
+/**
+ * @brief Runs one transfer on a simulated bus without the HAL
+ *
+ * @param[in] bus       Device node string of the bus
+ * @param[in] address   7 bit slave address
+ * @param[in] wBuf      Bytes to write, may be 0 when wLen is 0
+ * @param[in] wLen      Number of bytes to write
+ * @param[out] rBuf     Read buffer, may be 0 when rLen is 0
+ * @param[in] rLen      Number of bytes to read after a repeated START
+ *
+ * @retval 0 on success, 1 when the device did not answer
+ *
+ * Same as one I2C_RDWR transfer of the Linux HAL: START, the write message,
+ * the read message, STOP. For bus policies of __lightranger3_driver.hpp
+ * run against the simulator.
+ */
+uint8_t lightranger3_simI2cTransfer(const char *bus, uint8_t address, uint8_t *wBuf, uint16_t wLen, uint8_t *rBuf, uint16_t rLen);
+
+/**
+ * @brief Sets transition or integration latency
+ *
+ * @param[in] dev       Device index
+ * @param[in] which     _LIGHTRANGER3_SIM_LAT_* selector
+ * @param[in] us        Latency in microseconds
+ *
+ * The measurement latency is the one of the init default profile; other
+ * profiles scale it by CMD_CONFIG_A[15:12] + 1 over 15 and by 2 over
+ * CMD_CONFIG_B[15:12] + 1.
+ */
+void lightranger3_simSetLatency(uint8_t dev, uint8_t which, uint32_t us);
+
+/**
+ * @brief Sets supply current of a power state
+ *
+ * @param[in] dev       Device index
+ * @param[in] which     _LIGHTRANGER3_SIM_PWR_* selector
+ * @param[in] ua        Current in microamperes
+ *
+ * Defaults are standby 10, off 500, on 4000 and measurement 20000 uA, round
+ * figures for relative comparisons; set the values of the part at hand for
+ * absolute ones. A disabled device draws nothing.
+ */
+void lightranger3_simSetCurrent(uint8_t dev, uint8_t which, uint32_t ua);
+
+/**
+ * @brief Sets measurement latency jitter
+ *
+ * @param[in] dev       Device index
+ * @param[in] us        Each measurement takes up to this much longer,
+ *                      uniformly distributed
+ */
+void lightranger3_simSetJitter(uint8_t dev, uint32_t us);
+
+/**
+ * @brief Sets scripted measurement outcomes
+ *
+ * @param[in] dev       Device index
+ * @param[in] profile   Outcomes, replayed cyclically
+ * @param[in] len       Number of outcomes, 0 restores the default
+ */
+void lightranger3_simSetProfile(uint8_t dev, const T_lightranger3_simSample *profile, uint16_t len);
+
+/**
+ * @brief Power cycles simulated sensor
+ *
+ * All registers return to their power up values and the device comes back
+ * in standby, as after a brown-out. Counters are kept.
+ */
+void lightranger3_simPowerCycle(uint8_t dev);
+
+/**
+ * @brief Injects sensor fault
+ *
+ * @param[in] dev       Device index
+ * @param[in] fault     _LIGHTRANGER3_SIM_FAULT_* selector
+ * @param[in] count     Results affected by _LIGHTRANGER3_SIM_FAULT_ERROR_CODE,
+ *                      ignored by the other faults
+ *
+ * Stuck and hung faults stay until the command that clears them. A reset
+ * or power cycle clears every fault. The device does not answer on the bus
+ * while a reset runs.
+ */
+void lightranger3_simInjectFault(uint8_t dev, uint8_t fault, uint16_t count);
+
+/**
+ * @brief Drives enable line of simulated sensor
+ *
+ * @param[in] dev       Device index
+ * @param[in] state     0 powers the device down, it stops answering on the
+ *                      bus; 1 powers it up on its power up address
+ */
+void lightranger3_simSetEnable(uint8_t dev, uint8_t state);
+
+/**
+ * @brief Reads INT pin level of the simulated device
+ */
+uint8_t lightranger3_simIntGet(uint8_t dev);
+
+/**
+ * @brief Returns GPIO object whose INT pin follows the simulated device
+ *
+ * Pass it as gpioObj to the driver init.
+ */
+const uint8_t* lightranger3_simGpioObj(uint8_t dev);
+
+/**
+ * @brief Reads device counters
+ */
+void lightranger3_simGetStats(uint8_t dev, T_lightranger3_simStats *stats);
+
+/**
+ * @brief Reads virtual time of the bus, in microseconds
+ */
+uint64_t lightranger3_simTime(const char *bus);
+
+/**
+ * @brief Tick source returning the virtual time of the current bus
+ *
+ * Suitable for lightranger3_setTickSource.
+ */
+uint32_t lightranger3_simTickUs();
+
+                                                                       /** @} */
+#ifdef __cplusplus
+} // extern "C"
+#endif
+#endif
+                                                                       /** @} */
+/* -------------------------------------------------------------------------- */
+/*
+  __lightranger3_sim.h
+
+  Copyright (c) 2017, MikroElektonika - http://www.mikroe.com
+
+  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+   This product includes software developed by the MikroElektonika.
+
+4. Neither the name of the MikroElektonika nor the
+   names of its contributors may be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY MIKROELEKTRONIKA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL MIKROELEKTRONIKA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------------- */